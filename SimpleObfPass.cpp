@@ -6,10 +6,23 @@
  * simple, reversible, and non-malicious.
  * 
  * Techniques implemented:
- * - String XOR encryption with simple runtime decoding
+ * - String XOR encryption, decoded at startup by a module constructor or on
+ *   first use through the warp_rt runtime (-obf-string-decode)
  * - Insertion of benign bogus functions (dead code)
  * - Basic symbol renaming for private globals
  * - Minimal control flow obfuscation (dead conditional branches)
+ * - Encoded jump tables: dense switches dispatch through a table of
+ *   keyed, function-relative offsets decoded by one add
+ * 
+ * Debug info survives every technique: inserted instructions carry their
+ * neighbour's line marked as implicit code, inserted functions get
+ * artificial subprograms, and renamed symbols keep their original name as
+ * DWARF linkage name, so profiles of a stripped binary symbolize offline
+ * against the split debug file.
+ * 
+ * Per-entity reporting goes through optimization remarks (pass name
+ * "simple-obf"): -pass-remarks=simple-obf prints them, and
+ * -pass-remarks-output serializes them to YAML or bitstream.
  * 
  * ETHICAL USAGE: This tool should only be used for:
  * - Educational purposes and learning LLVM pass development
@@ -20,24 +33,78 @@
  * security measures. Users are responsible for compliance with applicable laws.
  */
 
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SetVector.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/Analysis/BlockFrequencyInfo.h"
+#include "llvm/Analysis/OptimizationRemarkEmitter.h"
+#include "llvm/Analysis/TargetTransformInfo.h"
 #include "llvm/Pass.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/Function.h"
 #include "llvm/IR/BasicBlock.h"
+#include "llvm/IR/CFG.h"
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/IRBuilder.h"
 #include "llvm/IR/Constants.h"
+#include "llvm/IR/DIBuilder.h"
+#include "llvm/IR/DebugInfoMetadata.h"
+#include "llvm/IR/InstIterator.h"
 #include "llvm/IR/GlobalVariable.h"
+#include "llvm/IR/Metadata.h"
+#include "llvm/IR/ReplaceConstant.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/GlobPattern.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/LineIterator.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/Process.h"
+#include "llvm/Support/TimeProfiler.h"
+#include "llvm/Support/Timer.h"
+#include "llvm/Support/xxhash.h"
+#include "llvm/Transforms/IPO/Internalize.h"
 #include "llvm/Transforms/Utils/BasicBlockUtils.h"
+#include "llvm/Transforms/Utils/ModuleUtils.h"
+#include <chrono>
+#include <cstdio>
 #include <random>
 #include <vector>
 #include <string>
 #include <fstream>
+#include <functional>
+#ifdef LLVM_ON_UNIX
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
 
 using namespace llvm;
 
+#define DEBUG_TYPE "simple-obf"
+
+// Pass statistics, reported by -stats / -stats-json. They are always enabled
+// so the counters stay live even when the plugin is built with NDEBUG.
+ALWAYS_ENABLED_STATISTIC(NumGlobalsScanned, "Number of globals scanned for string constants");
+ALWAYS_ENABLED_STATISTIC(NumStringsEncrypted, "Number of string constants encrypted");
+ALWAYS_ENABLED_STATISTIC(NumStringsSkippedPolicy, "Number of string constants skipped because other modules may define them");
+ALWAYS_ENABLED_STATISTIC(NumBytesEncrypted, "Number of string bytes encrypted");
+ALWAYS_ENABLED_STATISTIC(NumBogusFunctions, "Number of bogus functions inserted");
+ALWAYS_ENABLED_STATISTIC(NumGlobalsRenamed, "Number of private globals renamed");
+ALWAYS_ENABLED_STATISTIC(NumSymbolsInternalized, "Number of definitions internalized by the export list");
+ALWAYS_ENABLED_STATISTIC(NumProfileGlobalsSkipped, "Number of profile instrumentation globals left untouched");
+ALWAYS_ENABLED_STATISTIC(NumFunctionsScanned, "Number of functions considered for dead branches");
+ALWAYS_ENABLED_STATISTIC(NumFunctionsSkippedPolicy, "Number of functions skipped as imported or already obfuscated");
+ALWAYS_ENABLED_STATISTIC(NumFunctionsSkippedBudget, "Number of functions skipped by the per-cycle dead branch limit");
+ALWAYS_ENABLED_STATISTIC(NumFunctionsSplit, "Number of functions whose entry block was split");
+ALWAYS_ENABLED_STATISTIC(NumSwitchesEncoded, "Number of switches lowered to encoded jump tables");
+ALWAYS_ENABLED_STATISTIC(NumSwitchesSkipped, "Number of switches too small or sparse for a jump table");
+ALWAYS_ENABLED_STATISTIC(NumSwitchesSkippedInline, "Number of switches left in functions that may be inlined");
+ALWAYS_ENABLED_STATISTIC(NumInstructionsAdded, "Number of instructions added to the module");
+ALWAYS_ENABLED_STATISTIC(NumArtificialSubprograms, "Number of inserted functions given artificial debug info");
+
 // Command line options for the pass
 static cl::opt<int> XorKey("xor-key", 
     cl::desc("XOR key for string encryption"), 
@@ -47,10 +114,108 @@ static cl::opt<int> BogusCount("bogus-count",
     cl::desc("Number of bogus functions to insert"), 
     cl::init(2));
 
-static cl::opt<int> Cycles("cycles", 
+static cl::opt<int> Cycles("obf-cycles", 
     cl::desc("Number of obfuscation cycles to run"), 
     cl::init(1));
 
+// Techniques in timings[] order
+enum Technique { TechStrings, TechBogusFunctions, TechRenameGlobals, TechDeadConditionals,
+                 TechJumpTables };
+
+static cl::list<Technique> Techniques("obf-techniques", cl::CommaSeparated,
+    cl::desc("Techniques to apply (default: all)"),
+    cl::values(
+        clEnumValN(TechStrings, "strings", "String XOR encryption"),
+        clEnumValN(TechBogusFunctions, "bogus_functions", "Bogus function insertion"),
+        clEnumValN(TechRenameGlobals, "rename_globals", "Private global renaming"),
+        clEnumValN(TechDeadConditionals, "dead_conditionals", "Dead conditional insertion"),
+        clEnumValN(TechJumpTables, "jump_tables", "Encoded switch jump tables")));
+
+static cl::opt<unsigned> JumpTableMinCases("obf-jump-table-min-cases",
+    cl::desc("Cases a switch needs to be lowered to an encoded jump table"),
+    cl::init(4));
+
+static cl::opt<unsigned> JumpTableMinBlocks("obf-jump-table-min-blocks",
+    cl::desc("Blocks a function needs before its switches are encoded; smaller "
+             "functions and likely inline candidates keep their switches "
+             "(0 = encode every function)"),
+    cl::init(16));
+
+// How encrypted strings are decoded at run time. Every strategy but eager
+// calls into the warp_rt runtime library (runtime/warp_rt.c).
+enum StringDecodeStrategy { DecodeEager, DecodeLazy, DecodeBlob, DecodePaged, DecodeCompressed };
+
+static cl::opt<StringDecodeStrategy> StringDecode("obf-string-decode",
+    cl::desc("When encrypted strings are decoded"),
+    cl::init(DecodeEager),
+    cl::values(
+        clEnumValN(DecodeEager, "eager", "All strings by a module constructor"),
+        clEnumValN(DecodeLazy, "lazy", "Each string on its first use"),
+        clEnumValN(DecodeBlob, "blob", "All strings, packed in one blob, on the first use of any"),
+        clEnumValN(DecodePaged, "paged", "One page of the string blob at a time, on first use"),
+        clEnumValN(DecodeCompressed, "compressed",
+                   "All strings, LZ-compressed in one blob, by a module constructor")));
+
+static cl::opt<unsigned> DecodePageSize("obf-decode-page-size",
+    cl::desc("Page size of the paged string decode strategy"),
+    cl::init(4096));
+
+// Two-phase string profiling: an instrumented build records per-string
+// access counts and first-access times through warp_rt; a second build
+// decodes the hot strings eagerly and orders the rest by first access
+static cl::opt<bool> StringProfileGenerate("obf-string-profile-generate",
+    cl::desc("Count accesses to each protected string through warp_rt"),
+    cl::init(false));
+
+static cl::opt<std::string> StringProfileUse("obf-string-profile-use",
+    cl::desc("warp_rt string profile to choose eager or lazy decode and blob order by"),
+    cl::init(""));
+
+static cl::opt<unsigned> StringHotAccesses("obf-string-hot-accesses",
+    cl::desc("Profiled accesses from which a string is decoded eagerly at startup"),
+    cl::init(16));
+
+// Whole-program mode: internalize everything the list does not export, so
+// that string protection and renaming reach it. Only valid on a module that
+// holds the whole program or shared object (full LTO).
+static cl::opt<std::string> ExportList("obf-export-list",
+    cl::desc("Internalize every definition not named in this file (one symbol "
+             "or glob per line) before obfuscating"),
+    cl::init(""));
+
+static cl::opt<bool> StringPredecode("obf-string-predecode",
+    cl::desc("Decode lazily decoded strings ahead of use on a warp_rt background "
+             "thread, in profile or blob order"),
+    cl::init(false));
+
+static cl::opt<unsigned long long> Seed("obf-seed",
+    cl::desc("Seed for randomized choices (bogus function names)"),
+    cl::init(0));
+
+static cl::opt<std::string> TelemetryFile("obf-telemetry-file",
+    cl::desc("Path of the JSON telemetry file written by the pass "
+             "(default: a per-module name in -obf-telemetry-dir)"),
+    cl::init(""));
+
+static cl::opt<bool> EstimateOverhead("obf-estimate-overhead",
+    cl::desc("Estimate the per-call cost each function gains from the target cost model"),
+    cl::init(false));
+
+static cl::opt<std::string> TelemetryDir("obf-telemetry-dir",
+    cl::desc("Directory for per-module telemetry files"),
+    cl::init("."));
+
+static cl::opt<std::string> ProfileRemapFile("obf-profile-remap-file",
+    cl::desc("Write an original -> obfuscated symbol name map in the "
+             "llvm-profdata merge -remapping-file format"),
+    cl::init(""));
+
+// Obfuscation state recorded in the IR. Named metadata marks a module that
+// has already been processed; per-function metadata survives ThinLTO
+// function import, so imported copies are never obfuscated a second time.
+static const char *const ModuleStateMD = "warp_aai.obfuscated";
+static const char *const FunctionStateMD = "warp_aai.obf";
+
 namespace {
 struct SimpleObfPass : public ModulePass {
     static char ID;
@@ -59,98 +224,1182 @@ struct SimpleObfPass : public ModulePass {
     unsigned strings_obf_count = 0;
     unsigned fake_funcs_inserted = 0;
     unsigned cycles_completed = 0;
+    unsigned switches_encoded = 0;
+    
+    // Definitions the export list internalized; renamed like private globals
+    SmallPtrSet<GlobalValue *, 32> internalized;
+    
+    // Wall-clock seconds per technique, summed over all cycles. The trace
+    // name labels the technique in -time-trace output and the description
+    // its row in the -time-passes "SimpleObfPass techniques" group.
+    struct TechniqueTiming {
+        const char *name;
+        const char *traceName;
+        const char *description;
+        double seconds;
+    };
+    TechniqueTiming timings[5] = {
+        {"strings", "ObfStrings", "String XOR encryption", 0},
+        {"bogus_functions", "ObfBogusFunctions", "Bogus function insertion", 0},
+        {"rename_globals", "ObfRenameGlobals", "Private global renaming", 0},
+        {"dead_conditionals", "ObfDeadConditionals", "Dead conditional insertion", 0},
+        {"jump_tables", "ObfJumpTables", "Encoded switch jump tables", 0}
+    };
+    double total_seconds = 0;
+    
+    // Module size before and after obfuscation
+    size_t instructions_before = 0;
+    size_t instructions_after = 0;
+    
+    // Size attribution for warp_size_report.py: the pre-obfuscation name of
+    // every renamed symbol, and the technique that added or changed a symbol
+    DenseMap<const GlobalValue *, std::string> original_names;
+    DenseMap<const GlobalValue *, const char *> inserted_by;
+    DenseMap<const GlobalValue *, const char *> modified_by;
+    
+    // Static runtime cost of a function: the target cost model's latency and
+    // reciprocal throughput of every instruction, weighted by the block's
+    // frequency relative to the entry block, i.e. cost per call
+    struct CallCost {
+        double latency = 0;
+        double throughput = 0;
+    };
+    struct OverheadEstimate {
+        std::string function;
+        CallCost before;
+        CallCost after;
+        Optional<uint64_t> entryCount; // from profile data only
+        double latencyDelta() const { return after.latency - before.latency; }
+        double throughputDelta() const { return after.throughput - before.throughput; }
+        // Ranking key: per-call latency, times the call count when profiled
+        double weight() const { return latencyDelta() * (entryCount ? *entryCount : 1); }
+    };
+    DenseMap<const Function *, CallCost> cost_before;
+    std::vector<OverheadEstimate> overhead;
+    
+    // Module size and process memory around one technique run, to find the
+    // technique and cycle responsible for growth. Malloc usage covers the
+    // LLVMContext allocations (constants, types, metadata) the module makes.
+    struct GrowthSnapshot {
+        uint64_t instructions = 0;
+        uint64_t functions = 0;
+        uint64_t globals = 0;
+        uint64_t malloc_bytes = 0;
+        uint64_t rss_bytes = 0;
+    };
+    struct GrowthSample {
+        unsigned cycle;
+        const char *technique;
+        GrowthSnapshot before;
+        GrowthSnapshot after;
+    };
+    std::vector<GrowthSample> growth;
+    unsigned current_cycle = 0;
+    
+    // Strings encrypted in place, decoded per -obf-string-decode
+    std::vector<GlobalVariable *> encrypted_strings;
+    unsigned strings_decoded_eagerly = 0;
+    unsigned strings_decoded_lazily = 0;
+    uint64_t string_blob_bytes = 0; // blob, or compressed stream
+    
+    // String profiling: a stable ID per encrypted string (hash of its
+    // original name and plaintext) and the merged profile being used
+    struct StringProfile {
+        uint64_t accesses = 0;
+        uint64_t first_ns = 0; // 0 = never accessed
+    };
+    DenseMap<const GlobalVariable *, uint64_t> string_ids;
+    DenseMap<uint64_t, StringProfile> string_profile;
+    unsigned strings_instrumented = 0;
+    unsigned strings_predecoded = 0; // regions handed to the pre-decode thread
+    unsigned strings_profiled_hot = 0;
+    unsigned strings_profiled_cold = 0;
+    unsigned strings_unprofiled = 0;
+    
+    // Runtime descriptors in predicted access order, for the pre-decode
+    // thread: string order for lazy (first access when profiled), page
+    // order for paged, the single blob descriptor for blob
+    std::vector<Constant *> predecode_order;
+    
+    // Deterministic generator for randomized choices
+    std::mt19937_64 Rng;
     
     SimpleObfPass() : ModulePass(ID) {}
     
+    void getAnalysisUsage(AnalysisUsage &AU) const override {
+        if (EstimateOverhead) {
+            AU.addRequired<TargetTransformInfoWrapperPass>();
+            AU.addRequired<BlockFrequencyInfoWrapperPass>();
+        }
+    }
+    
     bool runOnModule(Module &M) override {
-        errs() << "[warp_aai] Starting obfuscation pass...\n";
+        if (M.getNamedMetadata(ModuleStateMD)) {
+            emitRemark(M, nullptr, [&](Function *F) {
+                return OptimizationRemarkMissed(DEBUG_TYPE, "ModuleSkipped", F)
+                       << "module already obfuscated";
+            });
+            return false;
+        }
         
+        TimeTraceScope PassScope("SimpleObfPass", M.getModuleIdentifier());
+        Rng.seed(Seed);
+        if (!StringProfileUse.empty())
+            loadStringProfile();
         bool changed = false;
+        auto start = std::chrono::steady_clock::now();
+        if (!ExportList.empty())
+            changed |= internalizeUnexported(M);
+        instructions_before = countInstructions(M);
+        if (EstimateOverhead) {
+            for (Function &F : M)
+                if (!F.isDeclaration())
+                    cost_before[&F] = callCost(F);
+        }
         
         // Run obfuscation for specified number of cycles
         for (int cycle = 0; cycle < Cycles; ++cycle) {
-            errs() << "[warp_aai] Running cycle " << (cycle + 1) << "/" << Cycles << "\n";
+            TimeTraceScope CycleScope("ObfCycle", [&] { return std::to_string(cycle + 1); });
+            current_cycle = cycle + 1;
             
             // Apply all obfuscation techniques
-            changed |= obfuscateStrings(M);
-            changed |= insertBogusFunctions(M);
-            changed |= renamePrivateGlobals(M);
-            changed |= insertDeadConditionals(M);
+            if (enabled(TechStrings))
+                changed |= timed(M, TechStrings, [&] { return obfuscateStrings(M); });
+            if (enabled(TechBogusFunctions))
+                changed |= timed(M, TechBogusFunctions, [&] { return insertBogusFunctions(M); });
+            if (enabled(TechRenameGlobals))
+                changed |= timed(M, TechRenameGlobals, [&] { return renamePrivateGlobals(M); });
+            if (enabled(TechDeadConditionals))
+                changed |= timed(M, TechDeadConditionals, [&] { return insertDeadConditionals(M); });
+            if (enabled(TechJumpTables))
+                changed |= timed(M, TechJumpTables, [&] { return encodeJumpTables(M); });
             
             cycles_completed++;
         }
         
+        if (!encrypted_strings.empty())
+            emitStringDecoders(M);
+        describeInsertedFunctions(M);
+        recordObfuscationState(M);
+        if (EstimateOverhead)
+            estimateOverhead(M);
+        instructions_after = countInstructions(M);
+        if (instructions_after > instructions_before)
+            NumInstructionsAdded += instructions_after - instructions_before;
+        total_seconds = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start).count();
+        
         // Output telemetry as JSON for parsing by wrapper script
-        outputTelemetry();
+        outputTelemetry(M);
+        if (!ProfileRemapFile.empty())
+            writeProfileRemap(M);
         
-        errs() << "[warp_aai] Obfuscation completed. "
-               << "Strings: " << strings_obf_count << ", "
-               << "Bogus funcs: " << fake_funcs_inserted << ", "
-               << "Cycles: " << cycles_completed << "\n";
+        emitRemark(M, nullptr, [&](Function *F) {
+            return OptimizationRemarkAnalysis(DEBUG_TYPE, "ObfuscationSummary", F)
+                   << "obfuscated module: "
+                   << ore::NV("Strings", strings_obf_count) << " strings, "
+                   << ore::NV("BogusFunctions", fake_funcs_inserted) << " bogus functions, "
+                   << ore::NV("Cycles", cycles_completed) << " cycles, "
+                   << ore::NV("InstructionsBefore", (uint64_t)instructions_before) << " -> "
+                   << ore::NV("InstructionsAfter", (uint64_t)instructions_after)
+                   << " instructions";
+        });
         
         return changed;
     }
     
 private:
+    static bool enabled(Technique T) {
+        return Techniques.empty() || is_contained(Techniques, T);
+    }
+    
+    /**
+     * Run one technique under a time-trace scope and a -time-passes timer,
+     * add its wall-clock time to timings[Idx] and record a growth sample
+     */
+    template <typename TransformFn>
+    bool timed(Module &M, unsigned Idx, TransformFn Transform) {
+        TechniqueTiming &T = timings[Idx];
+        GrowthSample Sample{current_cycle, T.name, snapshot(M), {}};
+        bool changed;
+        {
+            // Both snapshots stay outside the trace scope and the timer
+            TimeTraceScope Scope(T.traceName);
+            NamedRegionTimer Timer(T.name, T.description, DEBUG_TYPE,
+                                   "SimpleObfPass techniques", TimePassesIsEnabled);
+            
+            auto start = std::chrono::steady_clock::now();
+            changed = Transform();
+            T.seconds += std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - start).count();
+        }
+        
+        Sample.after = snapshot(M);
+        growth.push_back(Sample);
+        return changed;
+    }
+    
+    static GrowthSnapshot snapshot(const Module &M) {
+        GrowthSnapshot S;
+        S.instructions = countInstructions(M);
+        S.functions = M.size();
+        S.globals = M.global_size();
+        S.malloc_bytes = sys::Process::GetMallocUsage();
+        S.rss_bytes = residentBytes();
+        return S;
+    }
+    
+    // Current resident set size; 0 where /proc is unavailable
+    static uint64_t residentBytes() {
+#ifdef LLVM_ON_UNIX
+        if (FILE *Statm = fopen("/proc/self/statm", "r")) {
+            unsigned long long size = 0, resident = 0;
+            int fields = fscanf(Statm, "%llu %llu", &size, &resident);
+            fclose(Statm);
+            if (fields == 2)
+                return resident * (uint64_t)sysconf(_SC_PAGESIZE);
+        }
+#endif
+        return 0;
+    }
+    
+    // Peak resident set size of the process so far
+    static uint64_t peakResidentBytes() {
+#ifdef LLVM_ON_UNIX
+        struct rusage Usage;
+        if (getrusage(RUSAGE_SELF, &Usage) == 0) {
+#ifdef __APPLE__
+            return (uint64_t)Usage.ru_maxrss;        // bytes
+#else
+            return (uint64_t)Usage.ru_maxrss * 1024; // kilobytes
+#endif
+        }
+#endif
+        return 0;
+    }
+    
+    /**
+     * Function a remark about a global is attributed to: the first function
+     * referencing GV (through constant expressions), else the first
+     * function defined in the module
+     */
+    static Function *remarkAnchor(Module &M, GlobalValue *GV) {
+        if (GV) {
+            SmallVector<User*, 8> worklist(GV->user_begin(), GV->user_end());
+            SmallPtrSet<User*, 16> visited;
+            while (!worklist.empty()) {
+                User *U = worklist.pop_back_val();
+                if (!visited.insert(U).second) continue;
+                if (auto *I = dyn_cast<Instruction>(U)) return I->getFunction();
+                if (isa<ConstantExpr>(U)) worklist.append(U->user_begin(), U->user_end());
+            }
+        }
+        for (Function &F : M)
+            if (!F.isDeclaration()) return &F;
+        return nullptr;
+    }
+    
+    // Same test OptimizationRemarkEmitter::enabled() makes: printed or serialized
+    static bool remarksEnabled(LLVMContext &Ctx) {
+        return Ctx.getLLVMRemarkStreamer() ||
+               Ctx.getDiagHandlerPtr()->isAnyRemarkEnabled(DEBUG_TYPE);
+    }
+    
+    /**
+     * Emit a remark built by Build(F). The remark is only constructed when
+     * remarks are enabled for the context, so quiet runs pay nothing.
+     */
+    template <typename RemarkBuilderFn>
+    static void emitRemark(Function *F, RemarkBuilderFn Build) {
+        if (!F || !remarksEnabled(F->getContext())) return;
+        auto Remark = Build(F);
+        F->getContext().diagnose(Remark);
+    }
+    
+    /**
+     * Emit a remark about GV (or the module, for null), attributed to
+     * remarkAnchor(M, GV). The anchor search only runs when remarks are on.
+     */
+    template <typename RemarkBuilderFn>
+    static void emitRemark(Module &M, GlobalValue *GV, RemarkBuilderFn Build) {
+        if (!remarksEnabled(M.getContext())) return;
+        emitRemark(remarkAnchor(M, GV), Build);
+    }
+    
+    // Rename GV, remembering its first name across cycles
+    void renameGlobal(GlobalValue *GV, const Twine &NewName) {
+        auto Original = original_names.try_emplace(GV, GV->getName().str());
+        if (Original.second)
+            keepLinkageName(GV, Original.first->second);
+        GV->setName(NewName);
+    }
+    
+    /**
+     * Record Name as the DWARF linkage name of GV's debug info unless it
+     * already has one (C++ manglings stay as they are). Symbolizers then
+     * report the source symbol for the renamed one.
+     */
+    static void keepLinkageName(GlobalValue *GV, StringRef Name) {
+        MDString *Linkage = MDString::get(GV->getContext(), Name);
+        if (auto *F = dyn_cast<Function>(GV)) {
+            DISubprogram *SP = F->getSubprogram();
+            if (SP && SP->getLinkageName().empty())
+                SP->replaceLinkageName(Linkage);
+        } else if (auto *Var = dyn_cast<GlobalVariable>(GV)) {
+            SmallVector<DIGlobalVariableExpression *, 1> Exprs;
+            Var->getDebugInfo(Exprs);
+            for (DIGlobalVariableExpression *E : Exprs)
+                if (E->getVariable()->getLinkageName().empty())
+                    E->getVariable()->replaceOperandWith(5, Linkage); // linkageName
+        }
+    }
+    
+    /**
+     * Location for code inserted before Near: the line of Near, or of the
+     * first instruction after it that has one (expanded constant
+     * expressions have none), flagged as implicit code so debuggers and
+     * profilers treat it as compiler generated while still attributing its
+     * cost to that line
+     */
+    static DebugLoc artificialLoc(const Instruction *Near) {
+        LLVMContext &Ctx = Near->getContext();
+        for (const Instruction *I = Near; I; I = I->getNextNode())
+            if (const DebugLoc &DL = I->getDebugLoc())
+                return DILocation::get(Ctx, DL.getLine(), DL.getCol(), DL.getScope(),
+                                       DL.getInlinedAt(), /*ImplicitCode=*/true);
+        if (DISubprogram *SP = Near->getFunction()->getSubprogram())
+            return DILocation::get(Ctx, 0, 0, SP, nullptr, /*ImplicitCode=*/true);
+        return DebugLoc();
+    }
+    
+    /**
+     * Give each function the pass inserted an artificial DISubprogram in the
+     * module's first compile unit, named and linkage-named after its symbol,
+     * and a line 0 location on every instruction. Modules without debug
+     * info are left alone.
+     */
+    void describeInsertedFunctions(Module &M) {
+        if (M.debug_compile_units().empty()) return;
+        DICompileUnit *CU = *M.debug_compile_units_begin();
+        DIBuilder DIB(M, /*AllowUnresolved=*/false, CU);
+        DISubroutineType *Ty = DIB.createSubroutineType(DIB.getOrCreateTypeArray({}));
+        for (Function &F : M) {
+            if (F.isDeclaration() || F.getSubprogram() || !inserted_by.count(&F)) continue;
+            DISubprogram::DISPFlags Flags = DISubprogram::SPFlagDefinition;
+            if (F.hasLocalLinkage())
+                Flags |= DISubprogram::SPFlagLocalToUnit;
+            DISubprogram *SP = DIB.createFunction(CU->getFile(), F.getName(), F.getName(),
+                                                  CU->getFile(), 0, Ty, 0,
+                                                  DINode::FlagArtificial, Flags);
+            F.setSubprogram(SP);
+            for (Instruction &I : instructions(F))
+                if (!I.getDebugLoc())
+                    I.setDebugLoc(DILocation::get(M.getContext(), 0, 0, SP));
+            DIB.finalizeSubprogram(SP);
+            ++NumArtificialSubprograms;
+        }
+    }
+    
+    /**
+     * Counters, data and the name table of PGO instrumentation and coverage
+     * (__profc_*, __profd_*, __llvm_prf_nm, ...). The profile runtime finds
+     * them by symbol and section and writes the names into .profraw files,
+     * so encrypting or renaming them would produce profiles that match no
+     * function.
+     */
+    static bool isProfileData(const GlobalVariable &GV) {
+        StringRef Name = GV.getName();
+        StringRef Section = GV.getSection();
+        return Name.startswith("__prof") || Name.startswith("__llvm_prf_") ||
+               Name.startswith("__llvm_profile_") || Name.startswith("__llvm_coverage_") ||
+               Section.contains("llvm_prf_") || Section.contains("llvm_covmap");
+    }
+    
+    /**
+     * (original, obfuscated) profile names of every renamed function; only
+     * functions have profiles. Local functions appear in instrumentation
+     * profiles as "<source file>:<name>", so they get that form as well as
+     * the plain symbol name. The original side keeps the linkage the
+     * function had before the export list internalized it, which is the
+     * name a profile of the source build uses.
+     */
+    std::vector<std::pair<std::string, std::string>> profileRemapping(const Module &M) const {
+        std::vector<std::pair<std::string, std::string>> Pairs;
+        for (const Function &F : M) {
+            auto It = original_names.find(&F);
+            if (inserted_by.count(&F) || It == original_names.end() ||
+                It->second == F.getName())
+                continue;
+            Pairs.emplace_back(It->second, F.getName().str());
+            if (!F.hasLocalLinkage())
+                continue;
+            Pairs.emplace_back(internalized.count(&F)
+                                   ? It->second
+                                   : GlobalValue::getGlobalIdentifier(
+                                         It->second, F.getLinkage(), M.getSourceFileName()),
+                               F.getGlobalIdentifier());
+        }
+        return Pairs;
+    }
+    
+    void writeProfileRemap(const Module &M) {
+        std::error_code EC;
+        raw_fd_ostream OS(ProfileRemapFile, EC, sys::fs::OF_Text);
+        if (EC) {
+            errs() << "simple-obf: cannot write " << ProfileRemapFile << ": "
+                   << EC.message() << "\n";
+            return;
+        }
+        OS << "# Profile name remapping for " << M.getSourceFileName() << "\n"
+           << "# <original> <obfuscated>, for llvm-profdata merge -remapping-file\n";
+        for (const auto &P : profileRemapping(M))
+            OS << P.first << " " << P.second << "\n";
+    }
+    
+    CallCost callCost(Function &F) {
+        const TargetTransformInfo &TTI =
+            getAnalysis<TargetTransformInfoWrapperPass>().getTTI(F);
+        BlockFrequencyInfo &BFI = getAnalysis<BlockFrequencyInfoWrapperPass>(F).getBFI();
+        double entryFreq = BFI.getEntryFreq();
+        
+        CallCost cost;
+        for (BasicBlock &BB : F) {
+            double freq = BFI.getBlockFreq(&BB).getFrequency() / entryFreq;
+            for (Instruction &I : BB) {
+                if (auto V = TTI.getInstructionCost(&I, TargetTransformInfo::TCK_Latency).getValue())
+                    cost.latency += *V * freq;
+                if (auto V = TTI.getInstructionCost(&I, TargetTransformInfo::TCK_RecipThroughput).getValue())
+                    cost.throughput += *V * freq;
+            }
+        }
+        return cost;
+    }
+    
+    /**
+     * Compare every pre-existing function's per-call cost with its cost
+     * before the pass. Inserted functions are skipped: nothing calls them.
+     * Results are ranked by latency delta, weighted by the profiled entry
+     * count when there is one.
+     */
+    void estimateOverhead(Module &M) {
+        TimeTraceScope Scope("ObfEstimateOverhead");
+        for (Function &F : M) {
+            auto It = cost_before.find(&F);
+            if (It == cost_before.end()) continue;
+            
+            OverheadEstimate E;
+            E.function = F.getName().str();
+            E.before = It->second;
+            E.after = callCost(F);
+            if (auto Count = F.getEntryCount())
+                E.entryCount = Count->getCount();
+            if (E.latencyDelta() == 0 && E.throughputDelta() == 0) continue;
+            
+            emitRemark(&F, [&](Function *Fn) {
+                return OptimizationRemarkAnalysis(DEBUG_TYPE, "OverheadEstimate", Fn)
+                       << "estimated per-call cost "
+                       << ore::NV("LatencyBefore", (float)E.before.latency) << " -> "
+                       << ore::NV("LatencyAfter", (float)E.after.latency) << " latency, "
+                       << ore::NV("ThroughputBefore", (float)E.before.throughput) << " -> "
+                       << ore::NV("ThroughputAfter", (float)E.after.throughput)
+                       << " reciprocal throughput";
+            });
+            overhead.push_back(std::move(E));
+        }
+        llvm::stable_sort(overhead, [](const OverheadEstimate &A, const OverheadEstimate &B) {
+            return A.weight() > B.weight();
+        });
+    }
+    
+    static size_t countInstructions(const Module &M) {
+        size_t count = 0;
+        for (const Function &F : M)
+            count += F.getInstructionCount();
+        return count;
+    }
+    
     /**
      * Obfuscate string constants by XOR encryption
-     * Creates encrypted global arrays and simple decode helpers
+     * Encrypts them in place; emitStringDecoder adds the startup decoder
      */
     bool obfuscateStrings(Module &M) {
         std::vector<GlobalVariable*> stringGlobals;
         
         // Find string constants
         for (GlobalVariable &GV : M.globals()) {
+            ++NumGlobalsScanned;
             if (!GV.hasInitializer() || !GV.isConstant()) continue;
             
-            // Skip external linkage to avoid breaking ABI
-            if (GV.hasExternalLinkage()) continue;
+            auto *CDA = dyn_cast<ConstantDataArray>(GV.getInitializer());
+            if (!CDA || !CDA->isString()) continue;
             
-            if (auto *CDA = dyn_cast<ConstantDataArray>(GV.getInitializer())) {
-                if (CDA->isString()) {
-                    stringGlobals.push_back(&GV);
-                }
+            if (isProfileData(GV)) {
+                ++NumProfileGlobalsSkipped;
+                continue;
+            }
+            
+            // Only strings this module owns. Other modules may see external
+            // strings; linkonce/weak and comdat copies are merged at link
+            // time, and every module's decoder would XOR the kept copy again.
+            if (!GV.hasLocalLinkage() || GV.hasComdat()) {
+                ++NumStringsSkippedPolicy;
+                emitRemark(M, &GV, [&](Function *F) {
+                    return OptimizationRemarkMissed(DEBUG_TYPE, "StringSkipped", F)
+                           << "string constant " << ore::NV("Global", GV.getName())
+                           << " not encrypted: "
+                           << (GV.hasLocalLinkage() ? "in a comdat" : "not local to the module");
+                });
+                continue;
             }
+            
+            stringGlobals.push_back(&GV);
         }
         
         // Encrypt found strings
         for (GlobalVariable *GV : stringGlobals) {
             encryptString(M, GV);
             strings_obf_count++;
+            ++NumStringsEncrypted;
         }
         
         return !stringGlobals.empty();
     }
     
     /**
-     * Encrypt a single string global variable
+     * Encrypt a single string global variable in place. The global becomes
+     * writable so the module constructor can decode it before main.
      */
     void encryptString(Module &M, GlobalVariable *GV) {
+        TimeTraceScope Scope("ObfEncryptString", [&] { return GV->getName().str(); });
         auto *CDA = cast<ConstantDataArray>(GV->getInitializer());
-        StringRef originalStr = CDA->getAsCString();
+        StringRef originalStr = CDA->getRawDataValues();
         
-        // Create encrypted version
+        // Every byte, including the terminator, so the type is unchanged
         std::vector<uint8_t> encrypted;
         for (size_t i = 0; i < originalStr.size(); ++i) {
             encrypted.push_back(originalStr[i] ^ (XorKey & 0xFF));
         }
-        encrypted.push_back(0); // null terminator (also encrypted)
+        NumBytesEncrypted += encrypted.size();
+        
+        std::string originalName = GV->getName().str();
+        string_ids[GV] = xxHash64(originalName + '\0' + originalStr.str());
+        GV->setInitializer(ConstantDataArray::get(M.getContext(), encrypted));
+        GV->setConstant(false);
+        renameGlobal(GV, GV->getName() + "_obf");
+        encrypted_strings.push_back(GV);
+        
+        emitRemark(M, GV, [&](Function *F) {
+            return OptimizationRemark(DEBUG_TYPE, "StringEncrypted", F)
+                   << "encrypted string constant " << ore::NV("Global", originalName)
+                   << " as " << ore::NV("NewName", GV->getName())
+                   << " (" << ore::NV("Length", (uint64_t)encrypted.size()) << " bytes)";
+        });
+    }
+    
+    /**
+     * Arrange for every encrypted string to be decoded before it is read,
+     * as selected by -obf-string-decode. The lazy strategies rewrite each
+     * access into a runtime call, so strings with a use that cannot be
+     * rewritten (a global initializer, a PHI operand) fall back to the
+     * startup decoder.
+     */
+    void emitStringDecoders(Module &M) {
+        TimeTraceScope Scope("ObfStringDecoder");
+        for (GlobalVariable *GV : encrypted_strings)
+            GV->removeDeadConstantUsers();
+        if (StringProfileGenerate)
+            instrumentStringAccesses(M, encrypted_strings);
         
-        // Create new encrypted global
-        ArrayType *arrayType = ArrayType::get(Type::getInt8Ty(M.getContext()), encrypted.size());
-        Constant *encryptedData = ConstantDataArray::get(M.getContext(), encrypted);
+        std::vector<GlobalVariable *> eager, lazy;
+        for (GlobalVariable *GV : encrypted_strings) {
+            if (StringDecode == DecodeEager || StringDecode == DecodeCompressed ||
+                !accessesRewritable(GV) || profiledHot(GV))
+                eager.push_back(GV);
+            else
+                lazy.push_back(GV);
+        }
+        if (!string_profile.empty())
+            orderByFirstAccess(lazy);
         
-        GlobalVariable *encryptedGV = new GlobalVariable(
-            M, arrayType, true, GlobalValue::PrivateLinkage, 
-            encryptedData, GV->getName() + "_enc");
+        if (StringDecode == DecodeCompressed) {
+            emitCompressedStrings(M, eager);
+            eager.clear();
+        } else if (StringDecode == DecodeLazy) {
+            emitLazyStrings(M, lazy);
+        } else if (!lazy.empty()) {
+            emitBlobStrings(M, lazy, StringDecode == DecodePaged);
+        }
+        if (!eager.empty())
+            emitStringDecoder(M, eager);
+        if (StringPredecode && !predecode_order.empty())
+            emitPredecode(M);
         
-        // Replace the original initializer with encrypted version
-        // Note: In a full implementation, we'd create runtime decode helpers
-        // For this MVP, we just replace the data (decoder would be added separately)
-        GV->setInitializer(encryptedData);
-        GV->setName(GV->getName() + "_obf");
+        strings_decoded_eagerly = StringDecode == DecodeCompressed
+                                      ? encrypted_strings.size() : eager.size();
+        strings_decoded_lazily = encrypted_strings.size() - strings_decoded_eagerly;
+        encrypted_strings.clear();
         
-        errs() << "[warp_aai] Encrypted string: " << originalStr << " (len=" << originalStr.size() << ")\n";
+        emitRemark(M, nullptr, [&](Function *F) {
+            return OptimizationRemarkAnalysis(DEBUG_TYPE, "StringDecoder", F)
+                   << "decoding strings with the "
+                   << ore::NV("Strategy", decodeStrategyName()) << " strategy: "
+                   << ore::NV("Eager", strings_decoded_eagerly) << " at startup, "
+                   << ore::NV("Lazy", strings_decoded_lazily) << " on first use";
+        });
+    }
+    
+    /**
+     * Read a warp_rt string profile (see runtime/warp_rt_profile.c). Runs
+     * appended to the same file are merged: accesses add up and the
+     * earliest first access wins.
+     */
+    void loadStringProfile() {
+        auto Buffer = MemoryBuffer::getFile(StringProfileUse);
+        if (!Buffer) {
+            errs() << "simple-obf: cannot read " << StringProfileUse << ": "
+                   << Buffer.getError().message() << "\n";
+            return;
+        }
+        for (line_iterator Line(**Buffer, /*SkipBlanks=*/true, '#'); !Line.is_at_eof(); ++Line) {
+            SmallVector<StringRef, 3> Fields;
+            Line->split(Fields, ' ', -1, /*KeepEmpty=*/false);
+            uint64_t Id, Accesses, FirstNs;
+            if (Fields.size() != 3 || Fields[0].getAsInteger(16, Id) ||
+                Fields[1].getAsInteger(10, Accesses) || Fields[2].getAsInteger(10, FirstNs)) {
+                errs() << "simple-obf: " << StringProfileUse << ":" << Line.line_number()
+                       << ": malformed string profile line\n";
+                continue;
+            }
+            StringProfile &P = string_profile[Id];
+            P.accesses += Accesses;
+            if (FirstNs && (!P.first_ns || FirstNs < P.first_ns))
+                P.first_ns = FirstNs;
+        }
+    }
+    
+    // Profiled at or above -obf-string-hot-accesses; counts the profile
+    // coverage of every string it is asked about
+    bool profiledHot(GlobalVariable *GV) {
+        if (string_profile.empty()) return false;
+        auto It = string_profile.find(string_ids.lookup(GV));
+        if (It == string_profile.end()) {
+            ++strings_unprofiled;
+            return false;
+        }
+        if (!It->second.accesses)
+            ++strings_profiled_cold;
+        bool Hot = It->second.accesses >= StringHotAccesses;
+        if (Hot) {
+            ++strings_profiled_hot;
+            emitRemark(*GV->getParent(), GV, [&](Function *F) {
+                return OptimizationRemark(DEBUG_TYPE, "StringDecodedEagerly", F)
+                       << "string " << ore::NV("Global", GV->getName()) << " decoded at startup: "
+                       << ore::NV("Accesses", It->second.accesses) << " profiled accesses";
+            });
+        }
+        return Hot;
+    }
+    
+    // Strings read first come first, never-read ones last, so the blob
+    // pages a startup touches are contiguous
+    void orderByFirstAccess(std::vector<GlobalVariable *> &Strings) {
+        auto FirstAccess = [&](GlobalVariable *GV) {
+            auto It = string_profile.find(string_ids.lookup(GV));
+            return It == string_profile.end() || !It->second.first_ns
+                       ? UINT64_MAX : It->second.first_ns;
+        };
+        llvm::stable_sort(Strings, [&](GlobalVariable *A, GlobalVariable *B) {
+            return FirstAccess(A) < FirstAccess(B);
+        });
+    }
+    
+    // struct warp_rt_profile_entry { i64 id; i64 accesses; i64 first_ns; }
+    static StructType *profileEntryType(LLVMContext &Ctx) {
+        if (StructType *T = StructType::getTypeByName(Ctx, "struct.warp_rt_profile_entry"))
+            return T;
+        Type *I64 = Type::getInt64Ty(Ctx);
+        return StructType::create(Ctx, {I64, I64, I64}, "struct.warp_rt_profile_entry");
+    }
+    
+    /**
+     * Instrumented build: one warp_rt_profile_entry per string whose
+     * accesses can be rewritten, a warp_rt_profile_hit call before each
+     * access, and a constructor registering the entries with the runtime,
+     * which writes them to the profile file at exit
+     */
+    void instrumentStringAccesses(Module &M, ArrayRef<GlobalVariable *> Strings) {
+        LLVMContext &Ctx = M.getContext();
+        Type *VoidTy = Type::getVoidTy(Ctx);
+        Type *I64 = Type::getInt64Ty(Ctx);
+        StructType *EntryTy = profileEntryType(Ctx);
+        
+        std::vector<GlobalVariable *> instrumented;
+        std::vector<Constant *> entries;
+        for (GlobalVariable *GV : Strings) {
+            if (!accessesRewritable(GV)) continue;
+            instrumented.push_back(GV);
+            entries.push_back(ConstantStruct::get(EntryTy, {
+                ConstantInt::get(I64, string_ids.lookup(GV)), ConstantInt::get(I64, 0),
+                ConstantInt::get(I64, 0)}));
+        }
+        if (instrumented.empty()) return;
+        
+        auto *TableTy = ArrayType::get(EntryTy, entries.size());
+        GlobalVariable *Table = addStringGlobal(M, TableTy, ConstantArray::get(TableTy, entries),
+                                                "warp_string_profile");
+        FunctionCallee Hit = M.getOrInsertFunction("warp_rt_profile_hit", VoidTy,
+                                                   EntryTy->getPointerTo());
+        for (size_t i = 0; i < instrumented.size(); ++i) {
+            GlobalVariable *GV = instrumented[i];
+            rewriteAccesses(GV, [&](IRBuilder<> &B) -> Value * {
+                B.CreateCall(Hit, B.CreateConstInBoundsGEP2_64(TableTy, Table, 0, i));
+                return GV;
+            });
+        }
+        
+        FunctionCallee Register = M.getOrInsertFunction(
+            "warp_rt_profile_register", VoidTy, EntryTy->getPointerTo(), I64);
+        Function *Ctor = Function::Create(FunctionType::get(VoidTy, false),
+                                          GlobalValue::InternalLinkage,
+                                          "warp_register_string_profile", M);
+        IRBuilder<> B(BasicBlock::Create(Ctx, "entry", Ctor));
+        B.CreateCall(Register, {B.CreateConstInBoundsGEP2_64(TableTy, Table, 0, 0),
+                                ConstantInt::get(I64, entries.size())});
+        B.CreateRetVoid();
+        appendToGlobalCtors(M, Ctor, 0);
+        Ctor->setMetadata(FunctionStateMD, MDNode::get(Ctx, {}));
+        inserted_by[Ctor] = "strings";
+        strings_instrumented = instrumented.size();
+    }
+    
+    static const char *decodeStrategyName() {
+        switch (StringDecode) {
+        case DecodeEager: return "eager";
+        case DecodeLazy: return "lazy";
+        case DecodeBlob: return "blob";
+        case DecodePaged: return "paged";
+        case DecodeCompressed: return "compressed";
+        }
+        return "eager";
+    }
+    
+    // True when every use of GV is an instruction operand, directly or
+    // through constant expressions, that an access call can be placed before
+    static bool accessesRewritable(GlobalVariable *GV) {
+        SmallVector<User *, 8> worklist(GV->user_begin(), GV->user_end());
+        SmallPtrSet<User *, 16> visited;
+        while (!worklist.empty()) {
+            User *U = worklist.pop_back_val();
+            if (!visited.insert(U).second) continue;
+            if (auto *I = dyn_cast<Instruction>(U)) {
+                if (isa<PHINode>(I) || I->isEHPad()) return false;
+            } else if (isa<ConstantExpr>(U)) {
+                worklist.append(U->user_begin(), U->user_end());
+            } else {
+                return false;
+            }
+        }
+        return true;
+    }
+    
+    /**
+     * Replace every use of GV with the pointer Access(B) computes right
+     * before the using instruction. Constant expressions
+     * over GV are first expanded into instructions so each use has a place.
+     */
+    template <typename AccessFn>
+    void rewriteAccesses(GlobalVariable *GV, AccessFn Access) {
+        SmallVector<ConstantExpr *, 4> exprs;
+        for (User *U : GV->users())
+            if (auto *CE = dyn_cast<ConstantExpr>(U))
+                exprs.push_back(CE);
+        for (ConstantExpr *CE : exprs) {
+            SmallVector<User *, 8> worklist(CE->user_begin(), CE->user_end());
+            SmallPtrSet<User *, 16> visited;
+            SmallVector<Instruction *, 8> insts;
+            while (!worklist.empty()) {
+                User *U = worklist.pop_back_val();
+                if (!visited.insert(U).second) continue;
+                if (auto *I = dyn_cast<Instruction>(U)) insts.push_back(I);
+                else worklist.append(U->user_begin(), U->user_end());
+            }
+            for (Instruction *I : insts)
+                convertConstantExprsToInstructions(I, CE);
+        }
+        GV->removeDeadConstantUsers();
+        
+        SmallVector<Use *, 8> uses;
+        for (Use &U : GV->uses())
+            uses.push_back(&U);
+        for (Use *U : uses) {
+            auto *I = cast<Instruction>(U->getUser());
+            IRBuilder<> B(I);
+            B.SetCurrentDebugLocation(artificialLoc(I));
+            U->set(B.CreatePointerCast(Access(B), GV->getType()));
+            modified_by.try_emplace(I->getFunction(), "strings");
+        }
+    }
+    
+    void forgetGlobal(GlobalVariable *GV) {
+        original_names.erase(GV);
+        inserted_by.erase(GV);
+        string_ids.erase(GV);
+        internalized.erase(GV);
+    }
+    
+    static uint64_t stringSize(GlobalVariable *GV) {
+        return cast<ArrayType>(GV->getValueType())->getNumElements();
+    }
+    
+    // struct warp_rt_string { i8 *data; i64 size; i32 key; i32 state; }
+    static StructType *runtimeStringType(LLVMContext &Ctx) {
+        if (StructType *T = StructType::getTypeByName(Ctx, "struct.warp_rt_string"))
+            return T;
+        return StructType::create(Ctx, {Type::getInt8PtrTy(Ctx), Type::getInt64Ty(Ctx),
+                                        Type::getInt32Ty(Ctx), Type::getInt32Ty(Ctx)},
+                                  "struct.warp_rt_string");
+    }
+    
+    static Constant *runtimeString(LLVMContext &Ctx, Constant *Data, uint64_t Size) {
+        return ConstantStruct::get(runtimeStringType(Ctx), {
+            ConstantExpr::getPointerCast(Data, Type::getInt8PtrTy(Ctx)),
+            ConstantInt::get(Type::getInt64Ty(Ctx), Size),
+            ConstantInt::get(Type::getInt32Ty(Ctx), XorKey & 0xFF),
+            ConstantInt::get(Type::getInt32Ty(Ctx), 0)});
+    }
+    
+    GlobalVariable *addStringGlobal(Module &M, Type *Ty, Constant *Init, const Twine &Name) {
+        auto *GV = new GlobalVariable(M, Ty, false, GlobalValue::PrivateLinkage, Init, Name);
+        inserted_by[GV] = "strings";
+        return GV;
+    }
+    
+    /**
+     * Lazy: each string gets a warp_rt_string descriptor, and every access
+     * becomes warp_rt_lazy(&desc), which decodes the string on first call
+     */
+    void emitLazyStrings(Module &M, ArrayRef<GlobalVariable *> Strings) {
+        LLVMContext &Ctx = M.getContext();
+        StructType *DescTy = runtimeStringType(Ctx);
+        FunctionCallee Lazy = M.getOrInsertFunction(
+            "warp_rt_lazy", Type::getInt8PtrTy(Ctx), DescTy->getPointerTo());
+        for (GlobalVariable *GV : Strings) {
+            // The descriptor points at GV, so it gets its initializer only
+            // once the accesses are rewritten
+            GlobalVariable *Desc = addStringGlobal(M, DescTy, nullptr, "warp_string_desc");
+            rewriteAccesses(GV, [&](IRBuilder<> &B) { return B.CreateCall(Lazy, Desc); });
+            Desc->setInitializer(runtimeString(Ctx, GV, stringSize(GV)));
+            predecode_order.push_back(Desc);
+        }
+    }
+    
+    /**
+     * Hand predecode_order to warp_rt_predecode from a constructor, which
+     * decodes it on a background thread before the program gets there, and
+     * stop that thread again from a destructor
+     */
+    void emitPredecode(Module &M) {
+        LLVMContext &Ctx = M.getContext();
+        Type *VoidTy = Type::getVoidTy(Ctx);
+        Type *I64 = Type::getInt64Ty(Ctx);
+        PointerType *DescPtrTy = runtimeStringType(Ctx)->getPointerTo();
+        
+        auto *OrderTy = ArrayType::get(DescPtrTy, predecode_order.size());
+        GlobalVariable *Order = addStringGlobal(
+            M, OrderTy, ConstantArray::get(OrderTy, predecode_order), "warp_predecode_order");
+        Order->setConstant(true);
+        FunctionCallee Predecode = M.getOrInsertFunction(
+            "warp_rt_predecode", VoidTy, DescPtrTy->getPointerTo(), I64);
+        Function *Ctor = Function::Create(FunctionType::get(VoidTy, false),
+                                          GlobalValue::InternalLinkage, "warp_start_predecode", M);
+        IRBuilder<> B(BasicBlock::Create(Ctx, "entry", Ctor));
+        B.CreateCall(Predecode, {B.CreateConstInBoundsGEP2_64(OrderTy, Order, 0, 0),
+                                 ConstantInt::get(I64, predecode_order.size())});
+        B.CreateRetVoid();
+        // After the eager decoder and user constructors at the default priority
+        appendToGlobalCtors(M, Ctor, 65535);
+        Ctor->setMetadata(FunctionStateMD, MDNode::get(Ctx, {}));
+        inserted_by[Ctor] = "strings";
+        
+        // Stop and join the thread before the image goes away (exit, dlclose,
+        // a JIT freeing the module), so it never touches unmapped strings
+        Function *Dtor = Function::Create(FunctionType::get(VoidTy, false),
+                                          GlobalValue::InternalLinkage, "warp_stop_predecode", M);
+        B.SetInsertPoint(BasicBlock::Create(Ctx, "entry", Dtor));
+        B.CreateCall(M.getOrInsertFunction("warp_rt_predecode_stop", VoidTy));
+        B.CreateRetVoid();
+        appendToGlobalDtors(M, Dtor, 65535);
+        Dtor->setMetadata(FunctionStateMD, MDNode::get(Ctx, {}));
+        inserted_by[Dtor] = "strings";
+        strings_predecoded = predecode_order.size();
+        predecode_order.clear();
+    }
+    
+    // Concatenate the strings' bytes at offsets honouring their alignment
+    static std::vector<uint8_t> packStrings(ArrayRef<GlobalVariable *> Strings,
+                                            std::vector<uint64_t> &Offsets,
+                                            Align &MaxAlign) {
+        std::vector<uint8_t> blob;
+        for (GlobalVariable *GV : Strings) {
+            Align A = GV->getAlign().valueOrOne();
+            MaxAlign = std::max(MaxAlign, A);
+            blob.resize(alignTo(blob.size(), A));
+            Offsets.push_back(blob.size());
+            StringRef Data = cast<ConstantDataArray>(GV->getInitializer())->getRawDataValues();
+            blob.insert(blob.end(), Data.begin(), Data.end());
+        }
+        return blob;
+    }
+    
+    /**
+     * Blob: all strings move into one encrypted blob. Accesses call
+     * warp_rt_lazy on the blob's single descriptor (decoding everything on
+     * the first access), or, paged, warp_rt_paged, which decodes only the
+     * pages the accessed string spans.
+     */
+    void emitBlobStrings(Module &M, ArrayRef<GlobalVariable *> Strings, bool Paged) {
+        LLVMContext &Ctx = M.getContext();
+        Type *I8 = Type::getInt8Ty(Ctx);
+        Type *I64 = Type::getInt64Ty(Ctx);
+        Type *I8Ptr = Type::getInt8PtrTy(Ctx);
+        StructType *DescTy = runtimeStringType(Ctx);
+        uint64_t PageSize = std::max(1u, DecodePageSize.getValue());
+        
+        std::vector<uint64_t> offsets;
+        Align BlobAlign;
+        std::vector<uint8_t> bytes = packStrings(Strings, offsets, BlobAlign);
+        if (Paged && isPowerOf2_64(PageSize))
+            BlobAlign = std::max(BlobAlign, Align(PageSize));
+        string_blob_bytes = bytes.size();
+        
+        GlobalVariable *Blob = addStringGlobal(
+            M, ArrayType::get(I8, bytes.size()), ConstantDataArray::get(Ctx, bytes),
+            "warp_string_blob");
+        Blob->setAlignment(BlobAlign);
+        
+        std::function<Value *(IRBuilder<> &, uint64_t, uint64_t)> Access;
+        if (Paged) {
+            std::vector<Constant *> pages;
+            for (uint64_t Off = 0; Off < bytes.size(); Off += PageSize) {
+                Constant *Data = ConstantExpr::getInBoundsGetElementPtr(
+                    Blob->getValueType(), Blob,
+                    ArrayRef<Constant *>{ConstantInt::get(I64, 0), ConstantInt::get(I64, Off)});
+                pages.push_back(runtimeString(Ctx, Data, std::min(PageSize, bytes.size() - Off)));
+            }
+            auto *PagesTy = ArrayType::get(DescTy, pages.size());
+            GlobalVariable *Pages = addStringGlobal(
+                M, PagesTy, ConstantArray::get(PagesTy, pages), "warp_string_pages");
+            for (uint64_t Page = 0; Page < pages.size(); ++Page)
+                predecode_order.push_back(ConstantExpr::getInBoundsGetElementPtr(
+                    PagesTy, Pages,
+                    ArrayRef<Constant *>{ConstantInt::get(I64, 0), ConstantInt::get(I64, Page)}));
+            FunctionCallee PagedFn = M.getOrInsertFunction(
+                "warp_rt_paged", I8Ptr, DescTy->getPointerTo(), I64, I64, I64);
+            Access = [=](IRBuilder<> &B, uint64_t Off, uint64_t Size) -> Value * {
+                return B.CreateCall(PagedFn, {B.CreateConstInBoundsGEP2_64(PagesTy, Pages, 0, 0),
+                                              ConstantInt::get(I64, PageSize),
+                                              ConstantInt::get(I64, Off),
+                                              ConstantInt::get(I64, Size)});
+            };
+        } else {
+            GlobalVariable *Desc = addStringGlobal(
+                M, DescTy, runtimeString(Ctx, Blob, bytes.size()), "warp_string_desc");
+            predecode_order.push_back(Desc);
+            FunctionCallee Lazy = M.getOrInsertFunction(
+                "warp_rt_lazy", I8Ptr, DescTy->getPointerTo());
+            Access = [=](IRBuilder<> &B, uint64_t Off, uint64_t) -> Value * {
+                return B.CreateConstInBoundsGEP1_64(I8, B.CreateCall(Lazy, Desc), Off);
+            };
+        }
+        
+        for (size_t i = 0; i < Strings.size(); ++i) {
+            uint64_t Size = stringSize(Strings[i]);
+            rewriteAccesses(Strings[i], [&](IRBuilder<> &B) { return Access(B, offsets[i], Size); });
+            forgetGlobal(Strings[i]);
+            Strings[i]->eraseFromParent();
+        }
+    }
+    
+    /**
+     * LZ77-compress Data into the token stream warp_rt_decompress reads:
+     *   0x00 len bytes[len]      literal run
+     *   0x01 len off_lo off_hi   copy len bytes from off bytes back
+     * Greedy matching against the last position of each 4-byte prefix.
+     */
+    static std::vector<uint8_t> compressStrings(ArrayRef<uint8_t> Data) {
+        const size_t MinMatch = 4, MaxLen = 255, Window = 0xFFFF;
+        std::vector<uint8_t> out;
+        DenseMap<uint32_t, size_t> lastSeen;
+        size_t literalStart = 0;
+        auto flushLiterals = [&](size_t End) {
+            while (literalStart < End) {
+                size_t Len = std::min(MaxLen, End - literalStart);
+                out.push_back(0);
+                out.push_back(Len);
+                out.insert(out.end(), Data.begin() + literalStart, Data.begin() + literalStart + Len);
+                literalStart += Len;
+            }
+        };
+        auto prefix = [&](size_t Pos) {
+            return (uint32_t)Data[Pos] | (uint32_t)Data[Pos + 1] << 8 |
+                   (uint32_t)Data[Pos + 2] << 16 | (uint32_t)Data[Pos + 3] << 24;
+        };
+        
+        size_t Pos = 0;
+        while (Pos + MinMatch <= Data.size()) {
+            auto It = lastSeen.find(prefix(Pos));
+            size_t Len = 0, Off = 0;
+            if (It != lastSeen.end() && Pos - It->second <= Window) {
+                Off = Pos - It->second;
+                while (Len < MaxLen && Pos + Len < Data.size() &&
+                       Data[Pos + Len] == Data[Pos + Len - Off])
+                    ++Len;
+            }
+            lastSeen[prefix(Pos)] = Pos;
+            if (Len < MinMatch) {
+                ++Pos;
+                continue;
+            }
+            flushLiterals(Pos);
+            out.push_back(1);
+            out.push_back(Len);
+            out.push_back(Off & 0xFF);
+            out.push_back(Off >> 8);
+            Pos += Len;
+            literalStart = Pos;
+        }
+        flushLiterals(Data.size());
+        return out;
+    }
+    
+    /**
+     * Compressed: all strings are packed, compressed and encrypted into one
+     * constant stream that a startup constructor decompresses into a
+     * zero-initialized buffer (.bss). Strings become offsets into the buffer,
+     * so uses of any kind, including global initializers, carry over.
+     */
+    void emitCompressedStrings(Module &M, ArrayRef<GlobalVariable *> Strings) {
+        LLVMContext &Ctx = M.getContext();
+        Type *VoidTy = Type::getVoidTy(Ctx);
+        Type *I8 = Type::getInt8Ty(Ctx);
+        Type *I64 = Type::getInt64Ty(Ctx);
+        Type *I8Ptr = Type::getInt8PtrTy(Ctx);
+        uint8_t Key = XorKey & 0xFF;
+        
+        std::vector<uint64_t> offsets;
+        Align BufferAlign;
+        std::vector<uint8_t> plain = packStrings(Strings, offsets, BufferAlign);
+        for (uint8_t &C : plain)
+            C ^= Key; // packStrings sees the encrypted initializers
+        std::vector<uint8_t> packed = compressStrings(plain);
+        for (uint8_t &C : packed)
+            C ^= Key;
+        string_blob_bytes = packed.size();
+        
+        auto *BufferTy = ArrayType::get(I8, plain.size());
+        GlobalVariable *Buffer = addStringGlobal(M, BufferTy, ConstantAggregateZero::get(BufferTy),
+                                                 "warp_string_buffer");
+        Buffer->setAlignment(BufferAlign);
+        GlobalVariable *Packed = addStringGlobal(
+            M, ArrayType::get(I8, packed.size()), ConstantDataArray::get(Ctx, packed),
+            "warp_string_packed");
+        Packed->setConstant(true);
+        
+        for (size_t i = 0; i < Strings.size(); ++i) {
+            GlobalVariable *GV = Strings[i];
+            Constant *Addr = ConstantExpr::getInBoundsGetElementPtr(
+                BufferTy, Buffer,
+                ArrayRef<Constant *>{ConstantInt::get(I64, 0), ConstantInt::get(I64, offsets[i])});
+            GV->replaceAllUsesWith(ConstantExpr::getPointerCast(Addr, GV->getType()));
+            forgetGlobal(GV);
+            GV->eraseFromParent();
+        }
+        
+        FunctionCallee Decompress = M.getOrInsertFunction(
+            "warp_rt_decompress", I64, I8Ptr, I64, I8Ptr, I64, I8);
+        Function *Ctor = Function::Create(FunctionType::get(VoidTy, false),
+                                          GlobalValue::InternalLinkage, "warp_decode_strings", M);
+        IRBuilder<> B(BasicBlock::Create(Ctx, "entry", Ctor));
+        B.CreateCall(Decompress, {B.CreatePointerCast(Buffer, I8Ptr),
+                                  ConstantInt::get(I64, plain.size()),
+                                  B.CreatePointerCast(Packed, I8Ptr),
+                                  ConstantInt::get(I64, packed.size()),
+                                  loadKey(M, B)});
+        B.CreateRetVoid();
+        appendToGlobalCtors(M, Ctor, 0);
+        Ctor->setMetadata(FunctionStateMD, MDNode::get(Ctx, {}));
+        inserted_by[Ctor] = "strings";
+    }
+    
+    /**
+     * Read the XOR key with a volatile load from a private global so that
+     * GlobalOpt cannot evaluate a startup decoder at compile time and fold
+     * the plaintext back into the initializers
+     */
+    Value *loadKey(Module &M, IRBuilder<> &B) {
+        Type *I8 = B.getInt8Ty();
+        auto *KeyGV = new GlobalVariable(M, I8, false, GlobalValue::PrivateLinkage,
+                                         ConstantInt::get(I8, XorKey & 0xFF), "warp_xor_key");
+        LoadInst *Key = B.CreateLoad(I8, KeyGV, "key");
+        Key->setVolatile(true);
+        return Key;
+    }
+    
+    /**
+     * Emit the startup decoder for the given encrypted strings:
+     *
+     *   warp_xor_decode(i8 *p, i64 n): for each byte, p[i] ^= key
+     *   warp_decode_strings(): warp_xor_decode(str, len) per string
+     *
+     * registered as a priority-0 constructor so it runs before any user
+     * constructor.
+     */
+    void emitStringDecoder(Module &M, ArrayRef<GlobalVariable *> Strings) {
+        LLVMContext &Ctx = M.getContext();
+        Type *VoidTy = Type::getVoidTy(Ctx);
+        Type *I8 = Type::getInt8Ty(Ctx);
+        Type *I64 = Type::getInt64Ty(Ctx);
+        Type *I8Ptr = Type::getInt8PtrTy(Ctx);
+        
+        // void warp_xor_decode(i8 *p, i64 n, i8 key)
+        Function *Decode = Function::Create(
+            FunctionType::get(VoidTy, {I8Ptr, I64, I8}, false),
+            GlobalValue::InternalLinkage, "warp_xor_decode", M);
+        Decode->addFnAttr(Attribute::NoInline);
+        {
+            Argument *Ptr = Decode->getArg(0), *Len = Decode->getArg(1), *Key = Decode->getArg(2);
+            BasicBlock *Entry = BasicBlock::Create(Ctx, "entry", Decode);
+            BasicBlock *Loop = BasicBlock::Create(Ctx, "loop", Decode);
+            BasicBlock *Exit = BasicBlock::Create(Ctx, "exit", Decode);
+            IRBuilder<> B(Entry);
+            B.CreateCondBr(B.CreateICmpEQ(Len, ConstantInt::get(I64, 0)), Exit, Loop);
+            
+            B.SetInsertPoint(Loop);
+            PHINode *Idx = B.CreatePHI(I64, 2, "i");
+            Idx->addIncoming(ConstantInt::get(I64, 0), Entry);
+            Value *Addr = B.CreateInBoundsGEP(I8, Ptr, Idx);
+            B.CreateStore(B.CreateXor(B.CreateLoad(I8, Addr), Key), Addr);
+            Value *Next = B.CreateAdd(Idx, ConstantInt::get(I64, 1));
+            Idx->addIncoming(Next, Loop);
+            B.CreateCondBr(B.CreateICmpEQ(Next, Len), Exit, Loop);
+            
+            B.SetInsertPoint(Exit);
+            B.CreateRetVoid();
+        }
+        
+        Function *Ctor = Function::Create(FunctionType::get(VoidTy, false),
+                                          GlobalValue::InternalLinkage, "warp_decode_strings", M);
+        IRBuilder<> B(BasicBlock::Create(Ctx, "entry", Ctor));
+        Value *Key = loadKey(M, B);
+        for (GlobalVariable *GV : Strings)
+            B.CreateCall(Decode, {B.CreatePointerCast(GV, I8Ptr), ConstantInt::get(I64, stringSize(GV)), Key});
+        B.CreateRetVoid();
+        appendToGlobalCtors(M, Ctor, 0);
+        
+        for (Function *F : {Decode, Ctor}) {
+            F->setMetadata(FunctionStateMD, MDNode::get(Ctx, {}));
+            inserted_by[F] = "strings";
+        }
     }
     
     /**
@@ -162,7 +1411,8 @@ private:
         
         for (int i = 0; i < BogusCount; ++i) {
             // Create function name
-            std::string funcName = "bogus_func_" + std::to_string(i) + "_" + std::to_string(rand() % 10000);
+            std::string funcName = "bogus_func_" + std::to_string(i) + "_" + std::to_string(Rng() % 10000);
+            TimeTraceScope Scope("ObfBogusFunction", funcName);
             
             // Create function type: int bogus_func(int)
             FunctionType *FT = FunctionType::get(Type::getInt32Ty(Ctx), 
@@ -187,36 +1437,105 @@ private:
             // Return the computed value (which will never be used)
             Builder.CreateRet(Result);
             
+            inserted_by[BogusF] = "bogus_functions";
             fake_funcs_inserted++;
+            ++NumBogusFunctions;
             changed = true;
             
-            errs() << "[warp_aai] Inserted bogus function: " << funcName << "\n";
+            emitRemark(BogusF, [&](Function *F) {
+                return OptimizationRemark(DEBUG_TYPE, "BogusFunctionInserted", F)
+                       << "inserted bogus function " << ore::NV("Function", F);
+            });
         }
         
         return changed;
     }
     
     /**
-     * Rename private global variables by appending _obf suffix
+     * Give every definition the -obf-export-list file does not match
+     * internal linkage, using LLVM's internalizer, which keeps llvm.used
+     * members and comdats consistent. main and profile data are always
+     * kept, as the runtime looks them up by name.
+     */
+    bool internalizeUnexported(Module &M) {
+        auto Buffer = MemoryBuffer::getFile(ExportList);
+        if (!Buffer) {
+            errs() << "simple-obf: cannot read " << ExportList << ": "
+                   << Buffer.getError().message() << "\n";
+            return false;
+        }
+        std::vector<GlobPattern> exports;
+        for (line_iterator Line(**Buffer, /*SkipBlanks=*/true, '#'); !Line.is_at_eof(); ++Line) {
+            Expected<GlobPattern> Pattern = GlobPattern::create(Line->trim());
+            if (!Pattern) {
+                errs() << "simple-obf: " << ExportList << ":" << Line.line_number() << ": "
+                       << toString(Pattern.takeError()) << "\n";
+                continue;
+            }
+            exports.push_back(std::move(*Pattern));
+        }
+        
+        std::vector<GlobalValue *> external;
+        for (GlobalValue &GV : M.global_values())
+            if (!GV.isDeclaration() && !GV.hasLocalLinkage())
+                external.push_back(&GV);
+        internalizeModule(M, [&](const GlobalValue &GV) {
+            auto *Var = dyn_cast<GlobalVariable>(&GV);
+            if (GV.getName() == "main" || (Var && isProfileData(*Var)))
+                return true;
+            return llvm::any_of(exports, [&](const GlobPattern &P) {
+                return P.match(GV.getName());
+            });
+        });
+        
+        for (GlobalValue *GV : external) {
+            if (!GV->hasLocalLinkage()) continue;
+            internalized.insert(GV);
+            ++NumSymbolsInternalized;
+        }
+        emitRemark(M, nullptr, [&](Function *F) {
+            return OptimizationRemarkAnalysis(DEBUG_TYPE, "Internalized", F)
+                   << "internalized " << ore::NV("Symbols", (uint64_t)internalized.size())
+                   << " of " << ore::NV("Definitions", (uint64_t)external.size())
+                   << " external definitions not in the export list";
+        });
+        return !internalized.empty();
+    }
+    
+    /**
+     * Rename private global variables, and the definitions the export list
+     * internalized, by appending _obf suffix
      */
     bool renamePrivateGlobals(Module &M) {
         bool changed = false;
-        std::vector<GlobalVariable*> toRename;
+        std::vector<GlobalValue*> toRename;
         
-        // Collect private globals
-        for (GlobalVariable &GV : M.globals()) {
-            if (GV.hasPrivateLinkage() && !GV.getName().endswith("_obf") && 
-                !GV.getName().endswith("_enc")) {
-                toRename.push_back(&GV);
+        // Collect private globals and internalized definitions
+        for (GlobalValue &GV : M.global_values()) {
+            if (GV.getName().endswith("_obf")) continue;
+            auto *Var = dyn_cast<GlobalVariable>(&GV);
+            bool Private = Var && GV.hasPrivateLinkage();
+            if (!Private && !internalized.count(&GV)) continue;
+            if (Var && isProfileData(*Var)) {
+                ++NumProfileGlobalsSkipped;
+                continue;
             }
+            toRename.push_back(&GV);
         }
         
         // Rename them
-        for (GlobalVariable *GV : toRename) {
+        for (GlobalValue *GV : toRename) {
             std::string oldName = GV->getName().str();
-            GV->setName(oldName + "_obf");
+            renameGlobal(GV, oldName + "_obf");
+            ++NumGlobalsRenamed;
             changed = true;
-            errs() << "[warp_aai] Renamed global: " << oldName << " -> " << GV->getName() << "\n";
+            emitRemark(M, GV, [&](Function *F) {
+                return OptimizationRemark(DEBUG_TYPE, "GlobalRenamed", F)
+                       << (GV->hasPrivateLinkage() ? "renamed private global "
+                                                   : "renamed internalized symbol ")
+                       << ore::NV("From", oldName)
+                       << " to " << ore::NV("To", GV->getName());
+            });
         }
         
         return changed;
@@ -232,14 +1551,48 @@ private:
         // Only modify one function to keep things minimal and safe
         for (Function &F : M) {
             if (F.isDeclaration() || F.getName().startswith("bogus_func_")) continue;
-            if (functionsModified >= 1) break; // Limit to one function for safety
+            ++NumFunctionsScanned;
+            // Imported (available_externally) copies belong to another module
+            if (F.hasAvailableExternallyLinkage() || F.hasMetadata(FunctionStateMD)) {
+                ++NumFunctionsSkippedPolicy;
+                emitRemark(&F, [&](Function *Fn) {
+                    return OptimizationRemarkMissed(DEBUG_TYPE, "DeadBranchSkipped", Fn)
+                           << "no dead branch: function is imported or already obfuscated";
+                });
+                continue;
+            }
+            if (functionsModified >= 1) { // Limit to one function for safety
+                ++NumFunctionsSkippedBudget;
+                emitRemark(&F, [&](Function *Fn) {
+                    return OptimizationRemarkMissed(DEBUG_TYPE, "DeadBranchSkipped", Fn)
+                           << "no dead branch: per-cycle function limit reached";
+                });
+                continue;
+            }
+            
+            TimeTraceScope Scope("ObfDeadConditional", F.getName());
             
             // Insert dead conditional at function entry
             BasicBlock &EntryBB = F.getEntryBlock();
             if (EntryBB.empty()) continue;
             
             LLVMContext &Ctx = M.getContext();
-            IRBuilder<> Builder(&EntryBB, EntryBB.begin());
+            
+            // Keep static allocas in the entry block and split right after them
+            BasicBlock::iterator SplitPt = EntryBB.getFirstInsertionPt();
+            while (isa<AllocaInst>(*SplitPt)) ++SplitPt;
+            BasicBlock *ContBB = EntryBB.splitBasicBlock(SplitPt, "continue_obf");
+            Instruction *OldBr = EntryBB.getTerminator();
+            
+            // Create dead basic block (never executed)
+            BasicBlock *DeadBB = BasicBlock::Create(Ctx, "dead_branch_obf", &F, ContBB);
+            IRBuilder<> DeadBuilder(DeadBB);
+            DeadBuilder.SetCurrentDebugLocation(artificialLoc(OldBr));
+            DeadBuilder.CreateBr(ContBB);
+            
+            // Replace the unconditional branch left by the split
+            IRBuilder<> Builder(OldBr);
+            Builder.SetCurrentDebugLocation(artificialLoc(OldBr));
             
             // Create always-false condition: 0 == 1
             Value *Cond = Builder.CreateICmpEQ(
@@ -247,61 +1600,329 @@ private:
                 ConstantInt::get(Type::getInt32Ty(Ctx), 1)
             );
             
-            // Create dead basic block
-            BasicBlock *DeadBB = BasicBlock::Create(Ctx, "dead_branch_obf", &F);
-            BasicBlock *ContBB = BasicBlock::Create(Ctx, "continue_obf", &F);
-            
             // Create conditional branch (will always go to ContBB)
-            Builder.CreateCondBr(Cond, DeadBB, ContBB);
-            
-            // Dead basic block (never executed)
-            IRBuilder<> DeadBuilder(DeadBB);
-            DeadBuilder.CreateBr(ContBB);
-            
-            // Move rest of original entry block to continue block
-            IRBuilder<> ContBuilder(ContBB);
-            
-            // Note: In a full implementation, we'd properly move instructions
-            // For this MVP, we just create the structure
-            ContBuilder.CreateBr(&EntryBB); // This creates a simple loop structure
+            BranchInst *DeadBr = Builder.CreateCondBr(Cond, DeadBB, ContBB);
+            OldBr->eraseFromParent();
             
+            F.setMetadata(FunctionStateMD, MDNode::get(Ctx, {}));
+            modified_by[&F] = "dead_conditionals";
             functionsModified++;
+            ++NumFunctionsSplit;
             changed = true;
             
-            errs() << "[warp_aai] Added dead conditional to function: " << F.getName() << "\n";
-            break; // Only modify one function for safety
+            emitRemark(&F, [&](Function *Fn) {
+                return OptimizationRemark(DEBUG_TYPE, "DeadBranchInserted", DeadBr)
+                       << "inserted dead conditional branch in " << ore::NV("Function", Fn);
+            });
         }
         
         return changed;
     }
     
+    /**
+     * Lower dense switches to encoded jump tables. Each table entry is the
+     * target block's offset from a base block plus a per-switch key K:
+     *
+     *   entry[i] = (i32)(&&case_i - &&base) + K      ; entry[N] = default
+     *   goto *((&&base - K) + sext(entry[min(x - low, N)]))
+     *
+     * &&base - K is a link-time constant, so decoding is the one add in the
+     * indirect jump sequence, as with a PIC jump table, but the entries no
+     * longer read as small offsets into the function. Out-of-range values
+     * select the default entry instead of branching around the table.
+     *
+     * indirectbr and blockaddress make a function non-inlinable for good,
+     * so functions the inliner would likely take keep their switches.
+     */
+    bool encodeJumpTables(Module &M) {
+        bool changed = false;
+        for (Function &F : M) {
+            // Imported copies belong to another module
+            if (F.isDeclaration() || F.hasAvailableExternallyLinkage()) continue;
+            SmallVector<SwitchInst *, 4> switches;
+            for (BasicBlock &BB : F)
+                if (auto *SI = dyn_cast<SwitchInst>(BB.getTerminator()))
+                    switches.push_back(SI);
+            if (!switches.empty() && mayBeInlined(F)) {
+                NumSwitchesSkippedInline += switches.size();
+                emitRemark(&F, [&](Function *Fn) {
+                    return OptimizationRemarkMissed(DEBUG_TYPE, "JumpTableSkipped", Fn)
+                           << "kept the switches of " << ore::NV("Function", Fn) << " ("
+                           << ore::NV("Switches", (uint64_t)switches.size())
+                           << "): an encoded jump table would block inlining";
+                });
+                continue;
+            }
+            for (SwitchInst *SI : switches) {
+                if (!encodeSwitch(M, SI)) {
+                    ++NumSwitchesSkipped;
+                    continue;
+                }
+                F.setMetadata(FunctionStateMD, MDNode::get(M.getContext(), {}));
+                modified_by.try_emplace(&F, "jump_tables");
+                changed = true;
+            }
+        }
+        return changed;
+    }
+    
+    // Small functions, inline hints and the only call of a local function
+    static bool mayBeInlined(const Function &F) {
+        if (!JumpTableMinBlocks) return false;
+        return F.size() < JumpTableMinBlocks || F.hasFnAttribute(Attribute::AlwaysInline) ||
+               F.hasFnAttribute(Attribute::InlineHint) ||
+               (F.hasLocalLinkage() && F.hasOneUse());
+    }
+    
+    bool encodeSwitch(Module &M, SwitchInst *SI) {
+        auto *CondTy = cast<IntegerType>(SI->getCondition()->getType());
+        if (SI->getNumCases() < std::max(1u, JumpTableMinCases.getValue()) ||
+            CondTy->getBitWidth() > 64)
+            return false;
+        
+        // Case values read as signed or unsigned span different ranges
+        // (0..200 in i8 is 201 values unsigned but wraps to all 256 signed);
+        // index from the low end of the tighter one
+        APInt SLow = SI->case_begin()->getCaseValue()->getValue();
+        APInt SHigh = SLow, ULow = SLow, UHigh = SLow;
+        for (auto Case : SI->cases()) {
+            const APInt &V = Case.getCaseValue()->getValue();
+            SLow = APIntOps::smin(SLow, V);
+            SHigh = APIntOps::smax(SHigh, V);
+            ULow = APIntOps::umin(ULow, V);
+            UHigh = APIntOps::umax(UHigh, V);
+        }
+        APInt SSpan = SHigh - SLow, USpan = UHigh - ULow;
+        const APInt &Low = SSpan.ult(USpan) ? SLow : ULow;
+        
+        // Dense like a backend jump table: at least 40% of the range is cases.
+        // Range may be 2^width, so it is only ever compared as an i64.
+        uint64_t Range = APIntOps::umin(SSpan, USpan).getZExtValue() + 1;
+        if (Range == 0 || Range > SI->getNumCases() * 10 / 4)
+            return false;
+        
+        LLVMContext &Ctx = M.getContext();
+        Function &F = *SI->getFunction();
+        BasicBlock *BB = SI->getParent();
+        Type *I32 = Type::getInt32Ty(Ctx);
+        Type *I64 = Type::getInt64Ty(Ctx);
+        BasicBlock *Default = SI->getDefaultDest();
+        std::vector<BasicBlock *> targets(Range + 1, Default);
+        for (auto Case : SI->cases())
+            targets[(Case.getCaseValue()->getValue() - Low).getZExtValue()] = Case.getCaseSuccessor();
+        
+        // Keys stay within 2^30 so that every offset plus key fits an i32
+        int64_t Key = int64_t(Rng() % (1u << 30)) - (1 << 29);
+        Constant *Base = ConstantExpr::getPtrToInt(BlockAddress::get(&F, Default), I64);
+        std::vector<Constant *> entries;
+        for (BasicBlock *Target : targets) {
+            Constant *Offset = ConstantExpr::getSub(
+                ConstantExpr::getPtrToInt(BlockAddress::get(&F, Target), I64), Base);
+            entries.push_back(ConstantExpr::getAdd(ConstantExpr::getTrunc(Offset, I32),
+                                                   ConstantInt::get(I32, Key)));
+        }
+        auto *TableTy = ArrayType::get(I32, entries.size());
+        auto *Table = new GlobalVariable(M, TableTy, true, GlobalValue::PrivateLinkage,
+                                         ConstantArray::get(TableTy, entries), "warp_jump_table");
+        inserted_by[Table] = "jump_tables";
+        
+        IRBuilder<> B(SI);
+        B.SetCurrentDebugLocation(artificialLoc(SI));
+        Value *Index = B.CreateZExtOrTrunc(
+            B.CreateSub(SI->getCondition(), ConstantInt::get(Ctx, Low)), I64);
+        Value *InRange = B.CreateICmpULT(Index, ConstantInt::get(I64, Range));
+        Index = B.CreateSelect(InRange, Index, ConstantInt::get(I64, Range));
+        Value *Entry = B.CreateLoad(I32, B.CreateInBoundsGEP(TableTy, Table,
+                                                             {ConstantInt::get(I64, 0), Index}));
+        Value *Target = B.CreateAdd(ConstantExpr::getSub(Base, ConstantInt::get(I64, Key)),
+                                    B.CreateSExt(Entry, I64), "jump_target");
+        
+        // One destination per successor; PHIs keep one entry per edge
+        SmallSetVector<BasicBlock *, 8> successors(succ_begin(SI), succ_end(SI));
+        IndirectBrInst *Jump = B.CreateIndirectBr(B.CreateIntToPtr(Target, B.getInt8PtrTy()),
+                                                  successors.size());
+        for (BasicBlock *Succ : successors) {
+            Jump->addDestination(Succ);
+            for (PHINode &PN : Succ->phis()) {
+                bool Seen = false;
+                for (unsigned i = PN.getNumIncomingValues(); i-- > 0;) {
+                    if (PN.getIncomingBlock(i) != BB) continue;
+                    if (Seen)
+                        PN.removeIncomingValue(i, /*DeletePHIIfEmpty=*/false);
+                    Seen = true;
+                }
+            }
+        }
+        SI->eraseFromParent();
+        
+        switches_encoded++;
+        ++NumSwitchesEncoded;
+        emitRemark(&F, [&](Function *Fn) {
+            return OptimizationRemark(DEBUG_TYPE, "JumpTableEncoded", Jump)
+                   << "encoded switch as a jump table of "
+                   << ore::NV("Entries", (uint64_t)targets.size()) << " entries in "
+                   << ore::NV("Function", Fn);
+        });
+        return true;
+    }
+    
+    /**
+     * Record the settings this module was obfuscated with as named metadata
+     * (!warp_aai.obfuscated = !{!{seed, xor key, cycles}}). Its presence makes
+     * later runs of the pass on the same module a no-op.
+     */
+    void recordObfuscationState(Module &M) {
+        LLVMContext &Ctx = M.getContext();
+        Type *I64 = Type::getInt64Ty(Ctx);
+        Metadata *State[] = {
+            ConstantAsMetadata::get(ConstantInt::get(I64, Seed)),
+            ConstantAsMetadata::get(ConstantInt::get(I64, XorKey & 0xFF)),
+            ConstantAsMetadata::get(ConstantInt::get(I64, cycles_completed))
+        };
+        M.getOrInsertNamedMetadata(ModuleStateMD)->addOperand(MDNode::get(Ctx, State));
+    }
+    
+    /**
+     * Telemetry path: -obf-telemetry-file if given, otherwise a name unique to
+     * this module and process inside -obf-telemetry-dir, so that every TU of a
+     * parallel build leaves its own file for warp_telemetry_agg.py
+     */
+    std::string telemetryPath(const Module &M) {
+        if (!TelemetryFile.empty())
+            return TelemetryFile;
+        
+        std::string name;
+        raw_string_ostream NameOS(name);
+        NameOS << "warp_pass_telemetry_"
+               << format_hex_no_prefix(xxHash64(M.getModuleIdentifier()), 16) << "_"
+               << sys::Process::getProcessId() << ".json";
+        
+        SmallString<256> path(TelemetryDir);
+        sys::path::append(path, NameOS.str());
+        return std::string(path.str());
+    }
+    
     /**
      * Output telemetry data as JSON for the wrapper script to parse
      */
-    void outputTelemetry() {
+    void outputTelemetry(const Module &M) {
         // Write telemetry to a JSON file that the wrapper can read
+        std::string path = telemetryPath(M);
         std::error_code EC;
-        raw_fd_ostream TelemetryFile("warp_pass_telemetry.json", EC);
+        raw_fd_ostream TelemetryOS(path, EC);
         
         if (!EC) {
-            TelemetryFile << "{\n";
-            TelemetryFile << "  \"strings_obf_count\": " << strings_obf_count << ",\n";
-            TelemetryFile << "  \"fake_funcs_inserted\": " << fake_funcs_inserted << ",\n";
-            TelemetryFile << "  \"cycles_completed\": " << cycles_completed << ",\n";
-            TelemetryFile << "  \"xor_key\": " << XorKey << ",\n";
-            TelemetryFile << "  \"bogus_count_requested\": " << BogusCount << "\n";
-            TelemetryFile << "}\n";
-            TelemetryFile.close();
-            
-            errs() << "[warp_aai] Telemetry written to warp_pass_telemetry.json\n";
+            json::OStream J(TelemetryOS, 2);
+            J.object([&] {
+                J.attribute("module", M.getModuleIdentifier());
+                J.attribute("source_filename", M.getSourceFileName());
+                J.attribute("strings_obf_count", strings_obf_count);
+                J.attribute("fake_funcs_inserted", fake_funcs_inserted);
+                J.attribute("switches_encoded", switches_encoded);
+                J.attribute("symbols_internalized", (uint64_t)internalized.size());
+                J.attribute("cycles_completed", cycles_completed);
+                J.attribute("xor_key", (int)XorKey);
+                J.attribute("seed", (uint64_t)Seed);
+                J.attribute("bogus_count_requested", (int)BogusCount);
+                J.attribute("string_decode", decodeStrategyName());
+                J.attribute("strings_decoded_eagerly", strings_decoded_eagerly);
+                J.attribute("strings_decoded_lazily", strings_decoded_lazily);
+                J.attribute("string_blob_bytes", string_blob_bytes);
+                J.attribute("strings_predecoded", strings_predecoded);
+                if (StringProfileGenerate || !StringProfileUse.empty()) {
+                    J.attributeObject("string_profile", [&] {
+                        J.attribute("instrumented", strings_instrumented);
+                        J.attribute("entries_loaded", (uint64_t)string_profile.size());
+                        J.attribute("hot", strings_profiled_hot);
+                        J.attribute("never_accessed", strings_profiled_cold);
+                        J.attribute("unprofiled", strings_unprofiled);
+                    });
+                }
+                J.attributeArray("techniques", [&] {
+                    for (unsigned T = TechStrings; T <= TechJumpTables; ++T)
+                        if (enabled(Technique(T)))
+                            J.value(timings[T].name);
+                });
+                J.attribute("total_seconds", total_seconds);
+                J.attributeObject("technique_seconds", [&] {
+                    for (const TechniqueTiming &T : timings)
+                        J.attribute(T.name, T.seconds);
+                });
+                J.attribute("instructions_before", (uint64_t)instructions_before);
+                J.attribute("instructions_after", (uint64_t)instructions_after);
+                J.attribute("functions_after", (uint64_t)M.size());
+                J.attribute("globals_after", (uint64_t)M.global_size());
+                J.attribute("peak_rss_bytes", peakResidentBytes());
+                J.attributeArray("growth", [&] {
+                    auto writeSnapshot = [&](StringRef Key, const GrowthSnapshot &S) {
+                        J.attributeObject(Key, [&] {
+                            J.attribute("instructions", S.instructions);
+                            J.attribute("functions", S.functions);
+                            J.attribute("globals", S.globals);
+                            J.attribute("malloc_bytes", S.malloc_bytes);
+                            J.attribute("rss_bytes", S.rss_bytes);
+                        });
+                    };
+                    for (const GrowthSample &G : growth) {
+                        J.object([&] {
+                            J.attribute("cycle", G.cycle);
+                            J.attribute("technique", G.technique);
+                            writeSnapshot("before", G.before);
+                            writeSnapshot("after", G.after);
+                        });
+                    }
+                });
+                // Keyed by final symbol name, in module order
+                J.attributeObject("rename_map", [&] {
+                    for (const GlobalValue &GV : M.global_values()) {
+                        auto It = original_names.find(&GV);
+                        if (It != original_names.end())
+                            J.attribute(GV.getName(), It->second);
+                    }
+                });
+                // Keyed by obfuscated name; one original can have two
+                J.attributeObject("profile_remap", [&] {
+                    for (const auto &P : profileRemapping(M))
+                        J.attribute(P.second, P.first);
+                });
+                J.attributeObject("inserted_symbols", [&] {
+                    for (const GlobalValue &GV : M.global_values()) {
+                        auto It = inserted_by.find(&GV);
+                        if (It != inserted_by.end())
+                            J.attribute(GV.getName(), It->second);
+                    }
+                });
+                if (EstimateOverhead) {
+                    J.attributeArray("overhead", [&] {
+                        for (const OverheadEstimate &E : overhead) {
+                            J.object([&] {
+                                J.attribute("function", E.function);
+                                J.attribute("latency_before", E.before.latency);
+                                J.attribute("latency_after", E.after.latency);
+                                J.attribute("latency_delta", E.latencyDelta());
+                                J.attribute("throughput_before", E.before.throughput);
+                                J.attribute("throughput_after", E.after.throughput);
+                                J.attribute("throughput_delta", E.throughputDelta());
+                                if (E.entryCount)
+                                    J.attribute("entry_count", *E.entryCount);
+                            });
+                        }
+                    });
+                }
+                J.attributeObject("modified_functions", [&] {
+                    for (const Function &F : M) {
+                        auto It = modified_by.find(&F);
+                        if (It != modified_by.end())
+                            J.attribute(F.getName(), It->second);
+                    }
+                });
+            });
+            TelemetryOS << "\n";
+            TelemetryOS.close();
         } else {
-            errs() << "[warp_aai] Warning: Could not write telemetry file\n";
+            errs() << "[warp_aai] Warning: Could not write telemetry file " << path
+                   << ": " << EC.message() << "\n";
         }
-        
-        // Also output to stderr for debugging
-        errs() << "[warp_aai] TELEMETRY: {\"strings_obf_count\":" << strings_obf_count 
-               << ",\"fake_funcs_inserted\":" << fake_funcs_inserted 
-               << ",\"cycles_completed\":" << cycles_completed << "}\n";
     }
 };
 
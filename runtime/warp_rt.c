@@ -0,0 +1,138 @@
+/*
+ * warp_rt.c - Runtime support for warp_aai string protection
+ *
+ * EDUCATIONAL MVP ONLY - part of the warp_aai educational obfuscation toolchain.
+ */
+
+#include "warp_rt.h"
+#include "warp_rt_internal.h"
+#include "warp_rt_thresholds.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sched.h>
+#define WARP_RT_YIELD() sched_yield()
+#else
+#define WARP_RT_YIELD() ((void)0)
+#endif
+
+/*
+ * Kernel choice: the widest supported kernel whose size window holds the
+ * region. Windows come from warp_rt_bench measurements
+ * (warp_rt_thresholds.h): below a window SIMD setup costs more than it
+ * saves, and above it a wide kernel may lose to a narrower one once the
+ * data no longer fits in cache.
+ */
+#ifdef WARP_RT_X86
+static struct {
+    int probed;
+    int sse2;
+    int avx2;
+    int avx512;
+} cpu;
+
+static void probe_cpu(void) {
+    for (unsigned i = 0; i < warp_rt_kernel_count; i++) {
+        const struct warp_rt_kernel *k = &warp_rt_kernels[i];
+        int supported = k->supported();
+        if (k->fn == warp_rt_decode_sse2) cpu.sse2 = supported;
+        if (k->fn == warp_rt_decode_avx2) cpu.avx2 = supported;
+        if (k->fn == warp_rt_decode_avx512) cpu.avx512 = supported;
+    }
+    /* Racing probes store the same values */
+    __atomic_store_n(&cpu.probed, 1, __ATOMIC_RELEASE);
+}
+#endif
+
+#define IN_WINDOW(isa, size) ((size) >= WARP_RT_##isa##_MIN_BYTES && (size) < WARP_RT_##isa##_MAX_BYTES)
+
+void warp_rt_decode(uint8_t *data, uint64_t size, uint8_t key) {
+#ifdef WARP_RT_X86
+    if (!__atomic_load_n(&cpu.probed, __ATOMIC_ACQUIRE)) {
+        probe_cpu();
+    }
+    if (cpu.avx512 && IN_WINDOW(AVX512, size)) {
+        warp_rt_decode_avx512(data, size, key);
+    } else if (cpu.avx2 && IN_WINDOW(AVX2, size)) {
+        warp_rt_decode_avx2(data, size, key);
+    } else if (cpu.sse2 && IN_WINDOW(SSE2, size)) {
+        warp_rt_decode_sse2(data, size, key);
+    } else {
+        warp_rt_decode_scalar(data, size, key);
+    }
+#else
+    warp_rt_decode_scalar(data, size, key);
+#endif
+}
+
+char *warp_rt_lazy(struct warp_rt_string *s) {
+    uint32_t state = __atomic_load_n(&s->state, __ATOMIC_ACQUIRE);
+    if (state == WARP_RT_PLAIN) {
+        return (char *)s->data;
+    }
+
+    uint32_t expected = WARP_RT_ENCODED;
+    if (__atomic_compare_exchange_n(&s->state, &expected, WARP_RT_DECODING, 0,
+                                    __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE)) {
+        warp_rt_decode(s->data, s->size, (uint8_t)s->key);
+        __atomic_store_n(&s->state, WARP_RT_PLAIN, __ATOMIC_RELEASE);
+        return (char *)s->data;
+    }
+
+    /*
+     * Another thread has the region. The pre-decode thread may sit at idle
+     * priority for as long as the CPU stays busy, so its copy-in is
+     * finished here rather than waited for. A decoding thread runs at
+     * normal priority; spin briefly, then yield to it.
+     */
+    for (unsigned spins = 0;; spins++) {
+        state = __atomic_load_n(&s->state, __ATOMIC_ACQUIRE);
+        if (state == WARP_RT_PLAIN) {
+            break;
+        }
+        if (state == WARP_RT_PUBLISHING) {
+            warp_rt_predecode_help(s);
+        } else if (spins >= 64) {
+            WARP_RT_YIELD();
+        }
+    }
+    return (char *)s->data;
+}
+
+char *warp_rt_paged(struct warp_rt_string *pages, uint64_t page_size,
+                    uint64_t offset, uint64_t size) {
+    uint64_t first = offset / page_size;
+    uint64_t last = (offset + (size ? size - 1 : 0)) / page_size;
+    for (uint64_t page = first; page <= last; page++) {
+        warp_rt_lazy(&pages[page]);
+    }
+    return (char *)pages[0].data + offset;
+}
+
+/*
+ * Stream format (after XOR with key), a sequence of tokens:
+ *   0x00 len byte[len]          literal run, len 1-255
+ *   0x01 len off_lo off_hi      copy len bytes from off bytes back
+ */
+uint64_t warp_rt_decompress(uint8_t *dst, uint64_t dst_size,
+                            const uint8_t *src, uint64_t src_size, uint8_t key) {
+    uint64_t in = 0, out = 0;
+    while (in + 2 <= src_size) {
+        uint8_t tag = src[in++] ^ key;
+        uint64_t len = src[in++] ^ key;
+        if (tag == 0) {
+            if (in + len > src_size || out + len > dst_size) break;
+            for (uint64_t k = 0; k < len; k++) {
+                dst[out++] = src[in++] ^ key;
+            }
+        } else {
+            if (in + 2 > src_size) break;
+            uint64_t offset = (uint64_t)(src[in] ^ key) | ((uint64_t)(src[in + 1] ^ key) << 8);
+            in += 2;
+            if (offset == 0 || offset > out || out + len > dst_size) break;
+            for (uint64_t k = 0; k < len; k++, out++) {
+                dst[out] = dst[out - offset];
+            }
+        }
+    }
+    return out;
+}
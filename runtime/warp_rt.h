@@ -0,0 +1,101 @@
+/*
+ * warp_rt.h - Runtime support for warp_aai string protection
+ *
+ * EDUCATIONAL MVP ONLY - part of the warp_aai educational obfuscation toolchain.
+ *
+ * SimpleObfPass emits calls into this library for every string decode
+ * strategy except "eager", which is self-contained IR, and for string
+ * access profiling. The driver links libwarp_rt.a automatically when
+ * either is selected.
+ *
+ * The layout of struct warp_rt_string is mirrored by the pass
+ * ({ i8*, i64, i32, i32 }); keep both in sync.
+ */
+
+#ifndef WARP_RT_H
+#define WARP_RT_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * States of a lazily decoded region. PUBLISHING: the pre-decode thread has
+ * the plaintext ready in a buffer and is copying it in; any thread that
+ * needs the region copies it in as well instead of waiting.
+ */
+enum {
+    WARP_RT_ENCODED = 0,
+    WARP_RT_DECODING = 1,
+    WARP_RT_PLAIN = 2,
+    WARP_RT_PUBLISHING = 3
+};
+
+/* One region of XOR-encoded bytes, decoded in place on first access */
+struct warp_rt_string {
+    uint8_t *data;
+    uint64_t size;
+    uint32_t key;
+    uint32_t state;
+};
+
+/* XOR size bytes at data with key, in place */
+void warp_rt_decode(uint8_t *data, uint64_t size, uint8_t key);
+
+/* Decode s on first use (thread-safe); returns its plaintext */
+char *warp_rt_lazy(struct warp_rt_string *s);
+
+/*
+ * Decode the pages of a paged blob that overlap [offset, offset + size)
+ * and return a pointer to offset. pages[i] describes bytes
+ * [i * page_size, (i + 1) * page_size) of the blob.
+ */
+char *warp_rt_paged(struct warp_rt_string *pages, uint64_t page_size,
+                    uint64_t offset, uint64_t size);
+
+/*
+ * Decompress an XOR-encoded LZ stream produced by SimpleObfPass
+ * ("compressed" strategy) into dst. Returns the number of bytes written.
+ */
+uint64_t warp_rt_decompress(uint8_t *dst, uint64_t dst_size,
+                            const uint8_t *src, uint64_t src_size, uint8_t key);
+
+/*
+ * Decode order[0..count) in the background, in that order, on a thread at
+ * idle priority (-obf-string-predecode). Called from module constructors.
+ * WARP_RT_PREDECODE=0 disables it, =1 forces it on single-CPU machines.
+ */
+void warp_rt_predecode(struct warp_rt_string *const *order, uint64_t count);
+
+/*
+ * Stop the pre-decode thread and wait for it to leave the strings alone.
+ * Called from module destructors, before the image's strings are unmapped.
+ * Later warp_rt_predecode calls do nothing; their strings still decode on
+ * first use.
+ */
+void warp_rt_predecode_stop(void);
+
+/*
+ * String access profiling (-obf-string-profile-generate). The pass gives
+ * every protected string an entry with a stable ID, registers the module's
+ * entries at startup and calls warp_rt_profile_hit before each access. At
+ * exit the runtime appends every registered entry to the profile file:
+ * $WARP_RT_PROFILE_FILE, or warp_rt.profile in the working directory.
+ * Layout mirrored by the pass ({ i64, i64, i64 }).
+ */
+struct warp_rt_profile_entry {
+    uint64_t id;
+    uint64_t accesses;
+    uint64_t first_ns; /* first access, ns after the first registration; 0 = never */
+};
+
+void warp_rt_profile_register(struct warp_rt_profile_entry *entries, uint64_t count);
+void warp_rt_profile_hit(struct warp_rt_profile_entry *entry);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* WARP_RT_H */
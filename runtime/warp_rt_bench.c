@@ -0,0 +1,473 @@
+/*
+ * warp_rt_bench.c - Microbenchmarks for the warp_rt decode kernels
+ *
+ * EDUCATIONAL MVP ONLY - part of the warp_aai educational obfuscation toolchain.
+ *
+ * Measures every decode kernel the CPU supports (scalar, SSE2, AVX2,
+ * AVX-512) at power-of-two lengths from 1 byte to 16 MiB, on an aligned and
+ * a misaligned pointer, with the data in cache (hot: repeated calls on a
+ * warm buffer) and out of cache (cold: every line flushed before a single
+ * timed call). Results are reported in bytes per cycle; on x86 a cycle is
+ * a TSC tick, i.e. a cycle at the nominal frequency.
+ *
+ *   warp_rt_bench [--kernels scalar,sse2,...] [--min-size N] [--max-size N]
+ *                 [--repetitions N] [--min-time-ms MS] [--json FILE]
+ *                 [--emit-thresholds FILE] [--tolerance F] [--verify]
+ *
+ * --emit-thresholds writes the dispatch windows warp_rt.c compiles in
+ * (warp_rt_thresholds.h): for each SIMD kernel, the longest run of measured
+ * lengths at which it is within --tolerance (default 0.10) of every
+ * narrower kernel, or faster. The tolerance lets lengths where kernels tie
+ * count for the wider kernel.
+ * --verify checks every kernel against the scalar one instead of measuring.
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include "warp_rt_internal.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef WARP_RT_X86
+#include <immintrin.h>
+#endif
+
+#define MAX_KERNELS 8
+#define MAX_SIZES 64
+#define LINE 64
+
+struct options {
+    const char *kernels;
+    uint64_t min_size;
+    uint64_t max_size;
+    unsigned repetitions;
+    double min_time_ms;
+    const char *json;
+    const char *thresholds;
+    double tolerance;
+    int verify;
+};
+
+struct result {
+    const struct warp_rt_kernel *kernel;
+    uint64_t size;
+    int misaligned;
+    int cold;
+    uint64_t iterations;
+    double ticks_per_call;
+    double bytes_per_tick;
+};
+
+static double ticks_per_ns = 1.0;
+static const char *tick_unit = "ns";
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t ticks(void) {
+#ifdef WARP_RT_X86
+    _mm_lfence();
+    uint64_t t = __rdtsc();
+    _mm_lfence();
+    return t;
+#else
+    return now_ns();
+#endif
+}
+
+/* TSC rate against the monotonic clock, over ~20 ms */
+static void calibrate_ticks(void) {
+#ifdef WARP_RT_X86
+    uint64_t ns0 = now_ns(), t0 = ticks();
+    while (now_ns() - ns0 < 20000000u) {
+    }
+    ticks_per_ns = (double)(ticks() - t0) / (double)(now_ns() - ns0);
+    tick_unit = "cycle";
+#endif
+}
+
+static void flush(uint8_t *data, uint64_t size) {
+#ifdef WARP_RT_X86
+    for (uint64_t i = 0; i < size + LINE; i += LINE) {
+        _mm_clflush(data + i);
+    }
+    _mm_mfence();
+#else
+    /* Evict by sweeping a buffer larger than any last-level cache */
+    static uint8_t *sweep;
+    static const uint64_t sweep_size = 64u << 20;
+    if (!sweep && !(sweep = malloc(sweep_size))) return;
+    for (uint64_t i = 0; i < sweep_size; i += LINE) {
+        sweep[i]++;
+    }
+    (void)data;
+    (void)size;
+#endif
+}
+
+static int compare_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static double median(double *values, unsigned count) {
+    qsort(values, count, sizeof(double), compare_double);
+    return count % 2 ? values[count / 2] : (values[count / 2 - 1] + values[count / 2]) / 2;
+}
+
+/* Repeated calls on a warm buffer; iterations grow until a sample lasts min_time */
+static void bench_hot(const struct options *opt, struct result *r, uint8_t *data) {
+    double min_ticks = opt->min_time_ms * 1e6 * ticks_per_ns;
+    double samples[64];
+    unsigned reps = opt->repetitions < 64 ? opt->repetitions : 64;
+    uint64_t iterations = 1;
+
+    r->kernel->fn(data, r->size, 0x5a); /* warm up */
+    for (;;) {
+        uint64_t t0 = ticks();
+        for (uint64_t i = 0; i < iterations; i++) {
+            r->kernel->fn(data, r->size, 0x5a);
+        }
+        uint64_t elapsed = ticks() - t0;
+        if ((double)elapsed >= min_ticks || iterations >= (1ull << 40)) break;
+        iterations *= elapsed ? (uint64_t)(min_ticks / (double)elapsed) + 2 : 16;
+    }
+    for (unsigned s = 0; s < reps; s++) {
+        uint64_t t0 = ticks();
+        for (uint64_t i = 0; i < iterations; i++) {
+            r->kernel->fn(data, r->size, 0x5a);
+        }
+        samples[s] = (double)(ticks() - t0) / (double)iterations;
+    }
+    r->iterations = iterations;
+    r->ticks_per_call = median(samples, reps);
+}
+
+/* One call per sample, with every line of the buffer flushed first */
+static void bench_cold(const struct options *opt, struct result *r, uint8_t *data) {
+    double samples[64];
+    unsigned reps = opt->repetitions * 3 < 64 ? opt->repetitions * 3 : 64;
+    for (unsigned s = 0; s < reps; s++) {
+        flush(data, r->size);
+        uint64_t t0 = ticks();
+        r->kernel->fn(data, r->size, 0x5a);
+        samples[s] = (double)(ticks() - t0);
+    }
+    r->iterations = reps;
+    r->ticks_per_call = median(samples, reps);
+}
+
+static int selected(const struct options *opt, const char *name) {
+    if (!opt->kernels) return 1;
+    size_t len = strlen(name);
+    for (const char *p = opt->kernels; *p;) {
+        const char *end = strchr(p, ',');
+        size_t n = end ? (size_t)(end - p) : strlen(p);
+        if (n == len && strncmp(p, name, n) == 0) return 1;
+        p += n + (end != NULL);
+    }
+    return 0;
+}
+
+/* Every supported kernel must match the scalar one at all lengths and offsets */
+static int verify(void) {
+    enum { MAX_LEN = 1100, OFFSETS = 64 };
+    static uint8_t expect[MAX_LEN + OFFSETS], actual[MAX_LEN + OFFSETS];
+    int failures = 0;
+    srand(1);
+    for (unsigned k = 1; k < warp_rt_kernel_count; k++) {
+        const struct warp_rt_kernel *kernel = &warp_rt_kernels[k];
+        if (!kernel->supported()) {
+            printf("[INFO] %s: not supported on this CPU, skipped\n", kernel->name);
+            continue;
+        }
+        int failed = 0;
+        for (unsigned offset = 0; offset < OFFSETS && !failed; offset += 7) {
+            for (unsigned len = 0; len <= MAX_LEN; len++) {
+                for (unsigned i = 0; i < sizeof(expect); i++) {
+                    expect[i] = actual[i] = (uint8_t)rand();
+                }
+                uint8_t key = (uint8_t)(len * 31 + offset);
+                warp_rt_decode_scalar(expect + offset, len, key);
+                kernel->fn(actual + offset, len, key);
+                if (memcmp(expect, actual, sizeof(expect)) != 0) {
+                    printf("[ERROR] %s: mismatch at length %u, offset %u\n",
+                           kernel->name, len, offset);
+                    failed = 1;
+                    break;
+                }
+            }
+        }
+        printf("[INFO] %s: %s\n", kernel->name, failed ? "FAILED" : "matches scalar");
+        failures += failed;
+    }
+    return failures ? 1 : 0;
+}
+
+static double hot_bytes_per_tick(const struct result *results, unsigned count,
+                                 const struct warp_rt_kernel *kernel, uint64_t size) {
+    /* Mean of the aligned and misaligned measurements */
+    double sum = 0;
+    unsigned n = 0;
+    for (unsigned i = 0; i < count; i++) {
+        if (results[i].kernel == kernel && results[i].size == size && !results[i].cold) {
+            sum += results[i].bytes_per_tick;
+            n++;
+        }
+    }
+    return n ? sum / n : 0;
+}
+
+/*
+ * Window [*lo, *hi) of the longest run of measured sizes at which kernel
+ * tier t keeps up with every narrower measured kernel. *hi is UINT64_MAX
+ * when the run reaches the largest size. Returns 0 when there is no run.
+ */
+static int window(const struct options *opt, const struct result *results, unsigned count,
+                  const struct warp_rt_kernel **measured, unsigned t,
+                  const uint64_t *sizes, unsigned nsizes, uint64_t *lo, uint64_t *hi) {
+    unsigned best_start = 0, best_len = 0, start = 0;
+    for (unsigned s = 0; s <= nsizes; s++) {
+        int keeps_up = s < nsizes;
+        if (keeps_up) {
+            double mine = hot_bytes_per_tick(results, count, measured[t], sizes[s]);
+            for (unsigned lower = 0; lower < t; lower++) {
+                double other = hot_bytes_per_tick(results, count, measured[lower], sizes[s]);
+                if (mine < other * (1 - opt->tolerance)) keeps_up = 0;
+            }
+        }
+        if (keeps_up) continue;
+        if (s - start > best_len) {
+            best_start = start;
+            best_len = s - start;
+        }
+        start = s + 1;
+    }
+    if (!best_len) return 0;
+    *lo = sizes[best_start];
+    *hi = best_start + best_len < nsizes ? sizes[best_start + best_len] : UINT64_MAX;
+    return 1;
+}
+
+static void cpu_model(char *buf, size_t len) {
+    snprintf(buf, len, "unknown CPU");
+    FILE *f = fopen("/proc/cpuinfo", "r");
+    if (!f) return;
+    char line[512];
+    while (fgets(line, sizeof(line), f)) {
+        char *colon = strchr(line, ':');
+        if (strncmp(line, "model name", 10) == 0 && colon) {
+            snprintf(buf, len, "%s", colon + 2);
+            buf[strcspn(buf, "\n")] = 0;
+            break;
+        }
+    }
+    fclose(f);
+}
+
+/*
+ * Header for warp_rt.c: a MIN/MAX byte window per SIMD kernel. A kernel
+ * that was not measured (unsupported here, or filtered out) gets the
+ * window of the kernel below it; one that never keeps up gets an empty
+ * window, which disables it.
+ */
+static int emit_thresholds(const struct options *opt, const struct result *results, unsigned count,
+                           const uint64_t *sizes, unsigned nsizes) {
+    static const char *macros[] = {NULL, "WARP_RT_SSE2", "WARP_RT_AVX2", "WARP_RT_AVX512"};
+    const struct warp_rt_kernel *measured[MAX_KERNELS];
+    unsigned tiers = 0, tier_of[MAX_KERNELS];
+    for (unsigned k = 0; k < warp_rt_kernel_count; k++) {
+        tier_of[k] = ~0u;
+        for (unsigned i = 0; i < count; i++) {
+            if (results[i].kernel == &warp_rt_kernels[k]) {
+                tier_of[k] = tiers;
+                measured[tiers++] = &warp_rt_kernels[k];
+                break;
+            }
+        }
+    }
+
+    FILE *f = fopen(opt->thresholds, "w");
+    if (!f) {
+        perror(opt->thresholds);
+        return 1;
+    }
+    char model[256];
+    cpu_model(model, sizeof(model));
+    time_t now = time(NULL);
+    char date[32];
+    strftime(date, sizeof(date), "%Y-%m-%d", gmtime(&now));
+    fprintf(f, "/*\n"
+               " * warp_rt_thresholds.h - Decode kernel dispatch windows\n"
+               " *\n"
+               " * Generated by warp_rt_bench --emit-thresholds; do not edit by hand.\n"
+               " * Measured on %s, %s, hot buffers,\n"
+               " * sizes %llu-%llu, tolerance %.2f.\n"
+               " * Regenerate with: cmake --build build --target warp_rt_thresholds\n"
+               " *\n"
+               " * A kernel decodes regions of MIN <= size < MAX bytes.\n"
+               " */\n\n"
+               "#ifndef WARP_RT_THRESHOLDS_H\n#define WARP_RT_THRESHOLDS_H\n\n",
+            model, date, (unsigned long long)sizes[0], (unsigned long long)sizes[nsizes - 1],
+            opt->tolerance);
+
+    uint64_t lo = UINT64_MAX, hi = 0;
+    unsigned macro_count = sizeof(macros) / sizeof(macros[0]);
+    for (unsigned k = 1; k < warp_rt_kernel_count && k < macro_count; k++) {
+        if (tier_of[k] == ~0u) {
+            fprintf(f, "/* %s not measured: window of the narrower kernel */\n",
+                    warp_rt_kernels[k].name);
+        } else if (!window(opt, results, count, measured, tier_of[k], sizes, nsizes, &lo, &hi)) {
+            fprintf(f, "/* %s never kept up with a narrower kernel: disabled */\n",
+                    warp_rt_kernels[k].name);
+            lo = UINT64_MAX;
+            hi = 0;
+        }
+        if (lo == UINT64_MAX) fprintf(f, "#define %s_MIN_BYTES UINT64_MAX\n", macros[k]);
+        else fprintf(f, "#define %s_MIN_BYTES %lluull\n", macros[k], (unsigned long long)lo);
+        if (hi == UINT64_MAX) fprintf(f, "#define %s_MAX_BYTES UINT64_MAX\n\n", macros[k]);
+        else fprintf(f, "#define %s_MAX_BYTES %lluull\n\n", macros[k], (unsigned long long)hi);
+    }
+#ifndef WARP_RT_X86
+    fprintf(f, "/* No SIMD kernels on this architecture */\n");
+    for (unsigned k = 1; k < macro_count; k++) {
+        fprintf(f, "#define %s_MIN_BYTES UINT64_MAX\n#define %s_MAX_BYTES 0\n", macros[k], macros[k]);
+    }
+    fprintf(f, "\n");
+#endif
+    fprintf(f, "#endif /* WARP_RT_THRESHOLDS_H */\n");
+    fclose(f);
+    printf("[INFO] Dispatch thresholds written: %s\n", opt->thresholds);
+    return 0;
+}
+
+static void write_json(const char *path, const struct result *results, unsigned count) {
+    FILE *f = fopen(path, "w");
+    if (!f) {
+        perror(path);
+        return;
+    }
+    char model[256];
+    cpu_model(model, sizeof(model));
+    fprintf(f, "{\n  \"context\": {\"cpu\": \"%s\", \"tick_unit\": \"%s\", "
+               "\"ticks_per_ns\": %.4f},\n  \"benchmarks\": [\n",
+            model, tick_unit, ticks_per_ns);
+    for (unsigned i = 0; i < count; i++) {
+        const struct result *r = &results[i];
+        fprintf(f, "    {\"name\": \"decode/%s/%llu/%s/%s\", \"kernel\": \"%s\", "
+                   "\"bytes\": %llu, \"alignment\": \"%s\", \"cache\": \"%s\", "
+                   "\"iterations\": %llu, \"ticks_per_call\": %.3f, \"bytes_per_cycle\": %.4f}%s\n",
+                r->kernel->name, (unsigned long long)r->size,
+                r->misaligned ? "misaligned" : "aligned", r->cold ? "cold" : "hot",
+                r->kernel->name, (unsigned long long)r->size,
+                r->misaligned ? "misaligned" : "aligned", r->cold ? "cold" : "hot",
+                (unsigned long long)r->iterations, r->ticks_per_call, r->bytes_per_tick,
+                i + 1 < count ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+    fclose(f);
+    printf("[INFO] Benchmark report saved: %s\n", path);
+}
+
+static int parse_args(int argc, char **argv, struct options *opt) {
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+        if (strcmp(arg, "--verify") == 0) {
+            opt->verify = 1;
+            continue;
+        }
+        if (!value) {
+            fprintf(stderr, "warp_rt_bench: unknown option or missing value: %s\n", arg);
+            return 1;
+        }
+        if (strcmp(arg, "--kernels") == 0) opt->kernels = value;
+        else if (strcmp(arg, "--min-size") == 0) opt->min_size = strtoull(value, NULL, 0);
+        else if (strcmp(arg, "--max-size") == 0) opt->max_size = strtoull(value, NULL, 0);
+        else if (strcmp(arg, "--repetitions") == 0) opt->repetitions = (unsigned)atoi(value);
+        else if (strcmp(arg, "--min-time-ms") == 0) opt->min_time_ms = atof(value);
+        else if (strcmp(arg, "--json") == 0) opt->json = value;
+        else if (strcmp(arg, "--emit-thresholds") == 0) opt->thresholds = value;
+        else if (strcmp(arg, "--tolerance") == 0) opt->tolerance = atof(value);
+        else {
+            fprintf(stderr, "warp_rt_bench: unknown option: %s\n", arg);
+            return 1;
+        }
+        i++;
+    }
+    if (opt->min_size == 0 || opt->max_size < opt->min_size || opt->repetitions == 0) {
+        fprintf(stderr, "warp_rt_bench: need 0 < --min-size <= --max-size, --repetitions > 0\n");
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    struct options opt = {NULL, 1, 16u << 20, 5, 2.0, NULL, NULL, 0.10, 0};
+    if (parse_args(argc, argv, &opt)) return 2;
+    if (opt.verify) return verify();
+
+    uint64_t sizes[MAX_SIZES];
+    unsigned nsizes = 0;
+    for (uint64_t s = opt.min_size; s <= opt.max_size && nsizes < MAX_SIZES; s *= 2) {
+        sizes[nsizes++] = s;
+    }
+
+    /* 64-byte aligned base; the misaligned pointer is base + 1 */
+    uint8_t *raw = malloc(opt.max_size + 2 * LINE + 1);
+    if (!raw) {
+        fprintf(stderr, "warp_rt_bench: out of memory\n");
+        return 1;
+    }
+    uint8_t *base = (uint8_t *)(((uintptr_t)raw + LINE - 1) & ~(uintptr_t)(LINE - 1));
+    memset(base, 0x41, opt.max_size + LINE);
+
+    calibrate_ticks();
+    printf("[INFO] %s per ns: %.3f\n", tick_unit, ticks_per_ns);
+    printf("%-44s %14s %12s\n", "benchmark", "ticks/call", "bytes/cycle");
+
+    unsigned capacity = warp_rt_kernel_count * nsizes * 4, count = 0;
+    struct result *results = calloc(capacity, sizeof(*results));
+    for (unsigned k = 0; k < warp_rt_kernel_count; k++) {
+        const struct warp_rt_kernel *kernel = &warp_rt_kernels[k];
+        if (!selected(&opt, kernel->name)) continue;
+        if (!kernel->supported()) {
+            printf("[INFO] %s: not supported on this CPU, skipped\n", kernel->name);
+            continue;
+        }
+        for (unsigned s = 0; s < nsizes; s++) {
+            for (int cold = 0; cold <= 1; cold++) {
+                for (int misaligned = 0; misaligned <= 1; misaligned++) {
+                    struct result *r = &results[count++];
+                    r->kernel = kernel;
+                    r->size = sizes[s];
+                    r->misaligned = misaligned;
+                    r->cold = cold;
+                    uint8_t *data = base + misaligned;
+                    if (cold) bench_cold(&opt, r, data);
+                    else bench_hot(&opt, r, data);
+                    r->bytes_per_tick = r->ticks_per_call > 0 ? (double)r->size / r->ticks_per_call : 0;
+
+                    char name[96];
+                    snprintf(name, sizeof(name), "decode/%s/%llu/%s/%s", kernel->name,
+                             (unsigned long long)r->size, misaligned ? "misaligned" : "aligned",
+                             cold ? "cold" : "hot");
+                    printf("%-44s %14.1f %12.3f\n", name, r->ticks_per_call, r->bytes_per_tick);
+                }
+            }
+        }
+    }
+
+    int status = 0;
+    if (opt.json) write_json(opt.json, results, count);
+    if (opt.thresholds) status = emit_thresholds(&opt, results, count, sizes, nsizes);
+    free(results);
+    free(raw);
+    return status;
+}
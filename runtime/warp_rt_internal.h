@@ -0,0 +1,52 @@
+/*
+ * warp_rt_internal.h - Decode kernels behind warp_rt_decode
+ *
+ * EDUCATIONAL MVP ONLY - part of the warp_aai educational obfuscation toolchain.
+ *
+ * Shared by the runtime's dispatcher and warp_rt_bench, which measures
+ * every kernel and generates warp_rt_thresholds.h from the results.
+ */
+
+#ifndef WARP_RT_INTERNAL_H
+#define WARP_RT_INTERNAL_H
+
+#include <stdint.h>
+
+struct warp_rt_string;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define WARP_RT_X86 1
+#endif
+
+/* XOR size bytes at data with key, in place */
+typedef void (*warp_rt_kernel_fn)(uint8_t *data, uint64_t size, uint8_t key);
+
+struct warp_rt_kernel {
+    const char *name;
+    warp_rt_kernel_fn fn;
+    int (*supported)(void);
+};
+
+/* Kernels in dispatch tier order, scalar first */
+extern const struct warp_rt_kernel warp_rt_kernels[];
+extern const unsigned warp_rt_kernel_count;
+
+void warp_rt_decode_scalar(uint8_t *data, uint64_t size, uint8_t key);
+#ifdef WARP_RT_X86
+void warp_rt_decode_sse2(uint8_t *data, uint64_t size, uint8_t key);
+void warp_rt_decode_avx2(uint8_t *data, uint64_t size, uint8_t key);
+void warp_rt_decode_avx512(uint8_t *data, uint64_t size, uint8_t key);
+#endif
+
+/* Finish copying in s while it is WARP_RT_PUBLISHING (warp_rt_predecode.c) */
+void warp_rt_predecode_help(struct warp_rt_string *s);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* WARP_RT_INTERNAL_H */
@@ -0,0 +1,156 @@
+/*
+ * warp_rt_kernels.c - Scalar and SIMD XOR decode kernels
+ *
+ * EDUCATIONAL MVP ONLY - part of the warp_aai educational obfuscation toolchain.
+ *
+ * Every kernel uses unaligned loads and stores, so it accepts any pointer.
+ * The SIMD kernels carry per-function target attributes, so the runtime
+ * builds without -mavx2 and picks a kernel at run time (see warp_rt.c).
+ */
+
+#include "warp_rt_internal.h"
+
+#ifdef WARP_RT_X86
+#include <immintrin.h>
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define WARP_RT_TARGET(isa) __attribute__((target(isa)))
+#else
+#define WARP_RT_TARGET(isa)
+#endif
+
+/*
+ * Byte-at-a-time reference. Vectorization is disabled so "scalar" stays
+ * scalar in the measurements.
+ */
+#if defined(__GNUC__) && !defined(__clang__)
+__attribute__((optimize("no-tree-vectorize")))
+#endif
+void warp_rt_decode_scalar(uint8_t *data, uint64_t size, uint8_t key) {
+#if defined(__clang__)
+#pragma clang loop vectorize(disable) interleave(disable)
+#endif
+    for (uint64_t i = 0; i < size; i++) {
+        data[i] ^= key;
+    }
+}
+
+static int always_supported(void) {
+    return 1;
+}
+
+#ifdef WARP_RT_X86
+
+WARP_RT_TARGET("sse2")
+void warp_rt_decode_sse2(uint8_t *data, uint64_t size, uint8_t key) {
+    const __m128i k = _mm_set1_epi8((char)key);
+    uint64_t i = 0;
+    for (; i + 64 <= size; i += 64) {
+        __m128i a = _mm_loadu_si128((const __m128i *)(data + i));
+        __m128i b = _mm_loadu_si128((const __m128i *)(data + i + 16));
+        __m128i c = _mm_loadu_si128((const __m128i *)(data + i + 32));
+        __m128i d = _mm_loadu_si128((const __m128i *)(data + i + 48));
+        _mm_storeu_si128((__m128i *)(data + i), _mm_xor_si128(a, k));
+        _mm_storeu_si128((__m128i *)(data + i + 16), _mm_xor_si128(b, k));
+        _mm_storeu_si128((__m128i *)(data + i + 32), _mm_xor_si128(c, k));
+        _mm_storeu_si128((__m128i *)(data + i + 48), _mm_xor_si128(d, k));
+    }
+    for (; i + 16 <= size; i += 16) {
+        __m128i a = _mm_loadu_si128((const __m128i *)(data + i));
+        _mm_storeu_si128((__m128i *)(data + i), _mm_xor_si128(a, k));
+    }
+    warp_rt_decode_scalar(data + i, size - i, key);
+}
+
+WARP_RT_TARGET("avx2")
+void warp_rt_decode_avx2(uint8_t *data, uint64_t size, uint8_t key) {
+    const __m256i k = _mm256_set1_epi8((char)key);
+    uint64_t i = 0;
+    for (; i + 128 <= size; i += 128) {
+        __m256i a = _mm256_loadu_si256((const __m256i *)(data + i));
+        __m256i b = _mm256_loadu_si256((const __m256i *)(data + i + 32));
+        __m256i c = _mm256_loadu_si256((const __m256i *)(data + i + 64));
+        __m256i d = _mm256_loadu_si256((const __m256i *)(data + i + 96));
+        _mm256_storeu_si256((__m256i *)(data + i), _mm256_xor_si256(a, k));
+        _mm256_storeu_si256((__m256i *)(data + i + 32), _mm256_xor_si256(b, k));
+        _mm256_storeu_si256((__m256i *)(data + i + 64), _mm256_xor_si256(c, k));
+        _mm256_storeu_si256((__m256i *)(data + i + 96), _mm256_xor_si256(d, k));
+    }
+    for (; i + 32 <= size; i += 32) {
+        __m256i a = _mm256_loadu_si256((const __m256i *)(data + i));
+        _mm256_storeu_si256((__m256i *)(data + i), _mm256_xor_si256(a, k));
+    }
+    if (i + 16 <= size) {
+        __m128i a = _mm_loadu_si128((const __m128i *)(data + i));
+        _mm_storeu_si128((__m128i *)(data + i), _mm_xor_si128(a, _mm256_castsi256_si128(k)));
+        i += 16;
+    }
+    warp_rt_decode_scalar(data + i, size - i, key);
+}
+
+/* Needs AVX-512BW for the byte-masked tail */
+WARP_RT_TARGET("avx512f,avx512bw")
+void warp_rt_decode_avx512(uint8_t *data, uint64_t size, uint8_t key) {
+    const __m512i k = _mm512_set1_epi8((char)key);
+    uint64_t i = 0;
+    for (; i + 256 <= size; i += 256) {
+        __m512i a = _mm512_loadu_si512((const void *)(data + i));
+        __m512i b = _mm512_loadu_si512((const void *)(data + i + 64));
+        __m512i c = _mm512_loadu_si512((const void *)(data + i + 128));
+        __m512i d = _mm512_loadu_si512((const void *)(data + i + 192));
+        _mm512_storeu_si512((void *)(data + i), _mm512_xor_si512(a, k));
+        _mm512_storeu_si512((void *)(data + i + 64), _mm512_xor_si512(b, k));
+        _mm512_storeu_si512((void *)(data + i + 128), _mm512_xor_si512(c, k));
+        _mm512_storeu_si512((void *)(data + i + 192), _mm512_xor_si512(d, k));
+    }
+    for (; i + 64 <= size; i += 64) {
+        __m512i a = _mm512_loadu_si512((const void *)(data + i));
+        _mm512_storeu_si512((void *)(data + i), _mm512_xor_si512(a, k));
+    }
+    if (i < size) {
+        __mmask64 m = (1ULL << (size - i)) - 1;
+        __m512i a = _mm512_maskz_loadu_epi8(m, data + i);
+        _mm512_mask_storeu_epi8(data + i, m, _mm512_xor_si512(a, k));
+    }
+}
+
+#if defined(__GNUC__) || defined(__clang__)
+static int sse2_supported(void) {
+    return __builtin_cpu_supports("sse2");
+}
+
+static int avx2_supported(void) {
+    return __builtin_cpu_supports("avx2");
+}
+
+static int avx512_supported(void) {
+    return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+}
+#else
+/* Without a feature query, stay on the x86-64 baseline */
+static int sse2_supported(void) {
+    return 1;
+}
+
+static int avx2_supported(void) {
+    return 0;
+}
+
+static int avx512_supported(void) {
+    return 0;
+}
+#endif
+
+#endif /* WARP_RT_X86 */
+
+const struct warp_rt_kernel warp_rt_kernels[] = {
+    {"scalar", warp_rt_decode_scalar, always_supported},
+#ifdef WARP_RT_X86
+    {"sse2", warp_rt_decode_sse2, sse2_supported},
+    {"avx2", warp_rt_decode_avx2, avx2_supported},
+    {"avx512", warp_rt_decode_avx512, avx512_supported},
+#endif
+};
+
+const unsigned warp_rt_kernel_count = sizeof(warp_rt_kernels) / sizeof(warp_rt_kernels[0]);
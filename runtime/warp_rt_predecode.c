@@ -0,0 +1,228 @@
+/*
+ * warp_rt_predecode.c - Background pre-decoding of lazily decoded strings
+ *
+ * EDUCATIONAL MVP ONLY - part of the warp_aai educational obfuscation toolchain.
+ *
+ * Modules built with -obf-string-predecode hand the runtime their string
+ * descriptors in predicted access order from a constructor. One background
+ * thread per process walks those lists at idle priority, so a first access
+ * on the request path usually finds plaintext.
+ *
+ * The thread never claims a region while it decodes: an idle-priority
+ * thread can be starved for as long as the machine is busy, and anyone
+ * waiting on its claim would starve with it. It decodes a copy of the
+ * region in bounded chunks, giving up as soon as the program claims the
+ * region itself. It then marks the region WARP_RT_PUBLISHING and copies the
+ * plaintext in. A thread that needs the region meanwhile copies the same
+ * plaintext in itself (warp_rt_predecode_help) and carries on.
+ *
+ * The strings belong to the module image, so the thread must be gone
+ * before the image is: every module that starts it also registers a
+ * destructor calling warp_rt_predecode_stop, which makes the thread quit
+ * at its next region or chunk and joins it (exit, dlclose, a JIT freeing
+ * the module).
+ *
+ * WARP_RT_PREDECODE=0 turns the thread off and =1 forces it on. By default
+ * it runs only when more than one CPU is online.
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE /* SCHED_IDLE */
+#endif
+
+#include "warp_rt.h"
+#include "warp_rt_internal.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+/* One module's descriptors, decoded in order */
+struct predecode_list {
+    struct warp_rt_string *const *order;
+    uint64_t count;
+    struct predecode_list *next;
+};
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static struct predecode_list *head, *tail;
+static int running;  /* the thread has not yet decided to exit */
+static int joinable; /* thread exists and nobody has joined it */
+static pthread_t thread;
+static int stopping; /* set once by warp_rt_predecode_stop; read without the lock */
+
+/* Bytes decoded between checks that the program has not claimed the region */
+#define PREDECODE_CHUNK (16 * 1024)
+
+/*
+ * The region being published and its plaintext. Only the pre-decode thread
+ * sets them; helpers count themselves in users, and the buffer is freed
+ * once the region is cleared and no helper is left.
+ */
+static struct {
+    struct warp_rt_string *region;
+    const uint8_t *plain;
+    uint32_t users;
+} publishing;
+
+void warp_rt_predecode_help(struct warp_rt_string *s) {
+    __atomic_add_fetch(&publishing.users, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&publishing.region, __ATOMIC_SEQ_CST) == s &&
+        __atomic_load_n(&s->state, __ATOMIC_ACQUIRE) == WARP_RT_PUBLISHING) {
+        /* Both copies write the same bytes */
+        memcpy(s->data, publishing.plain, s->size);
+        uint32_t expected = WARP_RT_PUBLISHING;
+        __atomic_compare_exchange_n(&s->state, &expected, WARP_RT_PLAIN, 0,
+                                    __ATOMIC_RELEASE, __ATOMIC_RELAXED);
+    }
+    __atomic_sub_fetch(&publishing.users, 1, __ATOMIC_SEQ_CST);
+}
+
+static void predecode(struct warp_rt_string *s) {
+    if (!s->size || __atomic_load_n(&s->state, __ATOMIC_ACQUIRE) != WARP_RT_ENCODED) {
+        return;
+    }
+    uint8_t *plain = malloc(s->size);
+    if (!plain) {
+        return;
+    }
+    for (uint64_t offset = 0; offset < s->size; offset += PREDECODE_CHUNK) {
+        if (__atomic_load_n(&s->state, __ATOMIC_ACQUIRE) != WARP_RT_ENCODED ||
+            __atomic_load_n(&stopping, __ATOMIC_ACQUIRE)) {
+            free(plain); /* the program got there first, or is shutting down */
+            return;
+        }
+        uint64_t size = s->size - offset < PREDECODE_CHUNK ? s->size - offset : PREDECODE_CHUNK;
+        memcpy(plain + offset, s->data + offset, size);
+        warp_rt_decode(plain + offset, size, (uint8_t)s->key);
+    }
+
+    /* A copy read while the program was decoding in place is discarded,
+     * since the region then never returns to WARP_RT_ENCODED */
+    publishing.plain = plain;
+    __atomic_store_n(&publishing.region, s, __ATOMIC_SEQ_CST);
+    uint32_t expected = WARP_RT_ENCODED;
+    if (__atomic_compare_exchange_n(&s->state, &expected, WARP_RT_PUBLISHING, 0,
+                                    __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+        memcpy(s->data, plain, s->size);
+        expected = WARP_RT_PUBLISHING;
+        __atomic_compare_exchange_n(&s->state, &expected, WARP_RT_PLAIN, 0,
+                                    __ATOMIC_RELEASE, __ATOMIC_RELAXED);
+    }
+    __atomic_store_n(&publishing.region, NULL, __ATOMIC_SEQ_CST);
+    while (__atomic_load_n(&publishing.users, __ATOMIC_SEQ_CST)) {
+        sched_yield();
+    }
+    free(plain);
+}
+
+static int predecode_enabled(void) {
+    const char *env = getenv("WARP_RT_PREDECODE");
+    if (env && *env) {
+        return *env != '0';
+    }
+    return sysconf(_SC_NPROCESSORS_ONLN) > 1;
+}
+
+static void *predecode_thread(void *arg) {
+    (void)arg;
+#ifdef SCHED_IDLE
+    /* Only run when a CPU would otherwise idle */
+    struct sched_param param = {0};
+    pthread_setschedparam(pthread_self(), SCHED_IDLE, &param);
+#endif
+    for (;;) {
+        pthread_mutex_lock(&lock);
+        struct predecode_list *list = head;
+        if (!list || stopping) {
+            running = 0;
+            pthread_mutex_unlock(&lock);
+            return NULL;
+        }
+        head = list->next;
+        if (!head) {
+            tail = NULL;
+        }
+        pthread_mutex_unlock(&lock);
+
+        for (uint64_t i = 0; i < list->count && !__atomic_load_n(&stopping, __ATOMIC_ACQUIRE);
+             i++) {
+            predecode(list->order[i]);
+        }
+        free(list);
+    }
+}
+
+void warp_rt_predecode(struct warp_rt_string *const *order, uint64_t count) {
+    static int enabled = -1;
+    if (enabled < 0) {
+        enabled = predecode_enabled(); /* constructors run on one thread */
+    }
+    if (!enabled || !count) {
+        return;
+    }
+    struct predecode_list *list = malloc(sizeof(*list));
+    if (!list) {
+        return;
+    }
+    list->order = order;
+    list->count = count;
+    list->next = NULL;
+
+    pthread_mutex_lock(&lock);
+    if (stopping) {
+        pthread_mutex_unlock(&lock);
+        free(list);
+        return;
+    }
+    if (tail) {
+        tail->next = list;
+    } else {
+        head = list;
+    }
+    tail = list;
+    if (!running) {
+        if (joinable) {
+            /* The last thread ran out of work and is returning */
+            pthread_join(thread, NULL);
+        }
+        running = joinable = pthread_create(&thread, NULL, predecode_thread, NULL) == 0;
+    }
+    pthread_mutex_unlock(&lock);
+}
+
+void warp_rt_predecode_stop(void) {
+    pthread_mutex_lock(&lock);
+    __atomic_store_n(&stopping, 1, __ATOMIC_RELEASE);
+    int join = joinable;
+    joinable = 0;
+    while (head) {
+        struct predecode_list *next = head->next;
+        free(head);
+        head = next;
+    }
+    tail = NULL;
+    pthread_mutex_unlock(&lock);
+    if (join) {
+        pthread_join(thread, NULL);
+    }
+}
+#else
+/* No thread support: strings keep decoding on first use */
+void warp_rt_predecode(struct warp_rt_string *const *order, uint64_t count) {
+    (void)order;
+    (void)count;
+}
+
+void warp_rt_predecode_stop(void) {
+}
+
+/* Nothing is ever published */
+void warp_rt_predecode_help(struct warp_rt_string *s) {
+    (void)s;
+}
+#endif
@@ -0,0 +1,85 @@
+/*
+ * warp_rt_profile.c - String access profiling for warp_aai string protection
+ *
+ * EDUCATIONAL MVP ONLY - part of the warp_aai educational obfuscation toolchain.
+ *
+ * Profile file format, one line per string, appended once per run so that
+ * several training runs accumulate in one file:
+ *
+ *   # warp_rt string profile: <id> <accesses> <first access ns>
+ *   0123456789abcdef 42 183200
+ *
+ * IDs are hex. A string with 0 accesses was protected but never read.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "warp_rt.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/* Entries of one module, registered by its constructor */
+struct profile_table {
+    struct warp_rt_profile_entry *entries;
+    uint64_t count;
+    struct profile_table *next;
+};
+
+static struct profile_table *tables;
+static uint64_t start_ns;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+#ifdef _WIN32
+    timespec_get(&ts, TIME_UTC);
+#else
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+#endif
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static void write_profile(void) {
+    const char *path = getenv("WARP_RT_PROFILE_FILE");
+    FILE *f = fopen(path && *path ? path : "warp_rt.profile", "a");
+    if (!f) {
+        return;
+    }
+    fprintf(f, "# warp_rt string profile: <id> <accesses> <first access ns>\n");
+    for (struct profile_table *t = tables; t; t = t->next) {
+        for (uint64_t i = 0; i < t->count; i++) {
+            const struct warp_rt_profile_entry *e = &t->entries[i];
+            fprintf(f, "%016llx %llu %llu\n", (unsigned long long)e->id,
+                    (unsigned long long)__atomic_load_n(&e->accesses, __ATOMIC_RELAXED),
+                    (unsigned long long)__atomic_load_n(&e->first_ns, __ATOMIC_RELAXED));
+        }
+    }
+    fclose(f);
+}
+
+/* Called from module constructors, before any thread can record a hit */
+void warp_rt_profile_register(struct warp_rt_profile_entry *entries, uint64_t count) {
+    struct profile_table *t = malloc(sizeof(*t));
+    if (!t) {
+        return;
+    }
+    if (!tables) {
+        start_ns = now_ns();
+        atexit(write_profile);
+    }
+    t->entries = entries;
+    t->count = count;
+    t->next = tables;
+    tables = t;
+}
+
+void warp_rt_profile_hit(struct warp_rt_profile_entry *entry) {
+    __atomic_fetch_add(&entry->accesses, 1, __ATOMIC_RELAXED);
+    if (__atomic_load_n(&entry->first_ns, __ATOMIC_RELAXED) == 0) {
+        /* +1 keeps a hit in the first nanosecond distinct from "never" */
+        uint64_t expected = 0, first = now_ns() - start_ns + 1;
+        __atomic_compare_exchange_n(&entry->first_ns, &expected, first, 0,
+                                    __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+    }
+}
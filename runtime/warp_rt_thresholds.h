@@ -0,0 +1,24 @@
+/*
+ * warp_rt_thresholds.h - Decode kernel dispatch windows
+ *
+ * Generated by warp_rt_bench --emit-thresholds; do not edit by hand.
+ * Measured on Intel(R) Xeon(R) Processor, 2026-10-18, hot buffers,
+ * sizes 1-16777216, tolerance 0.10.
+ * Regenerate with: cmake --build build --target warp_rt_thresholds
+ *
+ * A kernel decodes regions of MIN <= size < MAX bytes.
+ */
+
+#ifndef WARP_RT_THRESHOLDS_H
+#define WARP_RT_THRESHOLDS_H
+
+#define WARP_RT_SSE2_MIN_BYTES 16ull
+#define WARP_RT_SSE2_MAX_BYTES UINT64_MAX
+
+#define WARP_RT_AVX2_MIN_BYTES 128ull
+#define WARP_RT_AVX2_MAX_BYTES UINT64_MAX
+
+#define WARP_RT_AVX512_MIN_BYTES 128ull
+#define WARP_RT_AVX512_MAX_BYTES 262144ull
+
+#endif /* WARP_RT_THRESHOLDS_H */
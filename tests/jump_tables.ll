@@ -0,0 +1,430 @@
+; Dense switches for the jump_tables technique: main prints a checksum
+; over every i8 value and a signed i16 window, so the original and the
+; obfuscated module must print the same line.
+;
+; sw8: cases 0..200, whose signed span wraps the whole i8 range
+; sw16: cases -120..120 step 2, whose unsigned span is almost all of i16
+
+@fmt = private unnamed_addr constant [10 x i8] c"sum %lld\0A\00"
+
+declare i32 @printf(i8*, ...)
+
+define internal i32 @sw8(i8 %x) {
+entry:
+  switch i8 %x, label %default [
+    i8 0, label %b0
+    i8 1, label %b1
+    i8 2, label %b2
+    i8 3, label %b3
+    i8 4, label %b4
+    i8 5, label %b5
+    i8 6, label %b6
+    i8 7, label %b7
+    i8 8, label %b8
+    i8 9, label %b0
+    i8 10, label %b1
+    i8 11, label %b2
+    i8 12, label %b3
+    i8 13, label %b4
+    i8 14, label %b5
+    i8 15, label %b6
+    i8 16, label %b7
+    i8 17, label %b8
+    i8 18, label %b0
+    i8 19, label %b1
+    i8 20, label %b2
+    i8 21, label %b3
+    i8 22, label %b4
+    i8 23, label %b5
+    i8 24, label %b6
+    i8 25, label %b7
+    i8 26, label %b8
+    i8 27, label %b0
+    i8 28, label %b1
+    i8 29, label %b2
+    i8 30, label %b3
+    i8 31, label %b4
+    i8 32, label %b5
+    i8 33, label %b6
+    i8 34, label %b7
+    i8 35, label %b8
+    i8 36, label %b0
+    i8 37, label %b1
+    i8 38, label %b2
+    i8 39, label %b3
+    i8 40, label %b4
+    i8 41, label %b5
+    i8 42, label %b6
+    i8 43, label %b7
+    i8 44, label %b8
+    i8 45, label %b0
+    i8 46, label %b1
+    i8 47, label %b2
+    i8 48, label %b3
+    i8 49, label %b4
+    i8 50, label %b5
+    i8 51, label %b6
+    i8 52, label %b7
+    i8 53, label %b8
+    i8 54, label %b0
+    i8 55, label %b1
+    i8 56, label %b2
+    i8 57, label %b3
+    i8 58, label %b4
+    i8 59, label %b5
+    i8 60, label %b6
+    i8 61, label %b7
+    i8 62, label %b8
+    i8 63, label %b0
+    i8 64, label %b1
+    i8 65, label %b2
+    i8 66, label %b3
+    i8 67, label %b4
+    i8 68, label %b5
+    i8 69, label %b6
+    i8 70, label %b7
+    i8 71, label %b8
+    i8 72, label %b0
+    i8 73, label %b1
+    i8 74, label %b2
+    i8 75, label %b3
+    i8 76, label %b4
+    i8 77, label %b5
+    i8 78, label %b6
+    i8 79, label %b7
+    i8 80, label %b8
+    i8 81, label %b0
+    i8 82, label %b1
+    i8 83, label %b2
+    i8 84, label %b3
+    i8 85, label %b4
+    i8 86, label %b5
+    i8 87, label %b6
+    i8 88, label %b7
+    i8 89, label %b8
+    i8 90, label %b0
+    i8 91, label %b1
+    i8 92, label %b2
+    i8 93, label %b3
+    i8 94, label %b4
+    i8 95, label %b5
+    i8 96, label %b6
+    i8 97, label %b7
+    i8 98, label %b8
+    i8 99, label %b0
+    i8 100, label %b1
+    i8 101, label %b2
+    i8 102, label %b3
+    i8 103, label %b4
+    i8 104, label %b5
+    i8 105, label %b6
+    i8 106, label %b7
+    i8 107, label %b8
+    i8 108, label %b0
+    i8 109, label %b1
+    i8 110, label %b2
+    i8 111, label %b3
+    i8 112, label %b4
+    i8 113, label %b5
+    i8 114, label %b6
+    i8 115, label %b7
+    i8 116, label %b8
+    i8 117, label %b0
+    i8 118, label %b1
+    i8 119, label %b2
+    i8 120, label %b3
+    i8 121, label %b4
+    i8 122, label %b5
+    i8 123, label %b6
+    i8 124, label %b7
+    i8 125, label %b8
+    i8 126, label %b0
+    i8 127, label %b1
+    i8 128, label %b2
+    i8 129, label %b3
+    i8 130, label %b4
+    i8 131, label %b5
+    i8 132, label %b6
+    i8 133, label %b7
+    i8 134, label %b8
+    i8 135, label %b0
+    i8 136, label %b1
+    i8 137, label %b2
+    i8 138, label %b3
+    i8 139, label %b4
+    i8 140, label %b5
+    i8 141, label %b6
+    i8 142, label %b7
+    i8 143, label %b8
+    i8 144, label %b0
+    i8 145, label %b1
+    i8 146, label %b2
+    i8 147, label %b3
+    i8 148, label %b4
+    i8 149, label %b5
+    i8 150, label %b6
+    i8 151, label %b7
+    i8 152, label %b8
+    i8 153, label %b0
+    i8 154, label %b1
+    i8 155, label %b2
+    i8 156, label %b3
+    i8 157, label %b4
+    i8 158, label %b5
+    i8 159, label %b6
+    i8 160, label %b7
+    i8 161, label %b8
+    i8 162, label %b0
+    i8 163, label %b1
+    i8 164, label %b2
+    i8 165, label %b3
+    i8 166, label %b4
+    i8 167, label %b5
+    i8 168, label %b6
+    i8 169, label %b7
+    i8 170, label %b8
+    i8 171, label %b0
+    i8 172, label %b1
+    i8 173, label %b2
+    i8 174, label %b3
+    i8 175, label %b4
+    i8 176, label %b5
+    i8 177, label %b6
+    i8 178, label %b7
+    i8 179, label %b8
+    i8 180, label %b0
+    i8 181, label %b1
+    i8 182, label %b2
+    i8 183, label %b3
+    i8 184, label %b4
+    i8 185, label %b5
+    i8 186, label %b6
+    i8 187, label %b7
+    i8 188, label %b8
+    i8 189, label %b0
+    i8 190, label %b1
+    i8 191, label %b2
+    i8 192, label %b3
+    i8 193, label %b4
+    i8 194, label %b5
+    i8 195, label %b6
+    i8 196, label %b7
+    i8 197, label %b8
+    i8 198, label %b0
+    i8 199, label %b1
+    i8 200, label %b2
+  ]
+b0:
+  br label %exit
+b1:
+  br label %exit
+b2:
+  br label %exit
+b3:
+  br label %exit
+b4:
+  br label %exit
+b5:
+  br label %exit
+b6:
+  br label %exit
+b7:
+  br label %exit
+b8:
+  br label %exit
+default:
+  br label %exit
+exit:
+  %r = phi i32 [ 11, %b0 ], [ 48, %b1 ], [ 85, %b2 ], [ 122, %b3 ], [ 159, %b4 ], [ 196, %b5 ], [ 233, %b6 ], [ 270, %b7 ], [ 307, %b8 ], [ 7, %default ]
+  ret i32 %r
+}
+
+define internal i32 @sw16(i16 %x) {
+entry:
+  switch i16 %x, label %default [
+    i16 -120, label %b6
+    i16 -118, label %b7
+    i16 -116, label %b8
+    i16 -114, label %b9
+    i16 -112, label %b10
+    i16 -110, label %b0
+    i16 -108, label %b1
+    i16 -106, label %b2
+    i16 -104, label %b3
+    i16 -102, label %b4
+    i16 -100, label %b5
+    i16 -98, label %b6
+    i16 -96, label %b7
+    i16 -94, label %b8
+    i16 -92, label %b9
+    i16 -90, label %b10
+    i16 -88, label %b0
+    i16 -86, label %b1
+    i16 -84, label %b2
+    i16 -82, label %b3
+    i16 -80, label %b4
+    i16 -78, label %b5
+    i16 -76, label %b6
+    i16 -74, label %b7
+    i16 -72, label %b8
+    i16 -70, label %b9
+    i16 -68, label %b10
+    i16 -66, label %b0
+    i16 -64, label %b1
+    i16 -62, label %b2
+    i16 -60, label %b3
+    i16 -58, label %b4
+    i16 -56, label %b5
+    i16 -54, label %b6
+    i16 -52, label %b7
+    i16 -50, label %b8
+    i16 -48, label %b9
+    i16 -46, label %b10
+    i16 -44, label %b0
+    i16 -42, label %b1
+    i16 -40, label %b2
+    i16 -38, label %b3
+    i16 -36, label %b4
+    i16 -34, label %b5
+    i16 -32, label %b6
+    i16 -30, label %b7
+    i16 -28, label %b8
+    i16 -26, label %b9
+    i16 -24, label %b10
+    i16 -22, label %b0
+    i16 -20, label %b1
+    i16 -18, label %b2
+    i16 -16, label %b3
+    i16 -14, label %b4
+    i16 -12, label %b5
+    i16 -10, label %b6
+    i16 -8, label %b7
+    i16 -6, label %b8
+    i16 -4, label %b9
+    i16 -2, label %b10
+    i16 0, label %b0
+    i16 2, label %b1
+    i16 4, label %b2
+    i16 6, label %b3
+    i16 8, label %b4
+    i16 10, label %b5
+    i16 12, label %b6
+    i16 14, label %b7
+    i16 16, label %b8
+    i16 18, label %b9
+    i16 20, label %b10
+    i16 22, label %b0
+    i16 24, label %b1
+    i16 26, label %b2
+    i16 28, label %b3
+    i16 30, label %b4
+    i16 32, label %b5
+    i16 34, label %b6
+    i16 36, label %b7
+    i16 38, label %b8
+    i16 40, label %b9
+    i16 42, label %b10
+    i16 44, label %b0
+    i16 46, label %b1
+    i16 48, label %b2
+    i16 50, label %b3
+    i16 52, label %b4
+    i16 54, label %b5
+    i16 56, label %b6
+    i16 58, label %b7
+    i16 60, label %b8
+    i16 62, label %b9
+    i16 64, label %b10
+    i16 66, label %b0
+    i16 68, label %b1
+    i16 70, label %b2
+    i16 72, label %b3
+    i16 74, label %b4
+    i16 76, label %b5
+    i16 78, label %b6
+    i16 80, label %b7
+    i16 82, label %b8
+    i16 84, label %b9
+    i16 86, label %b10
+    i16 88, label %b0
+    i16 90, label %b1
+    i16 92, label %b2
+    i16 94, label %b3
+    i16 96, label %b4
+    i16 98, label %b5
+    i16 100, label %b6
+    i16 102, label %b7
+    i16 104, label %b8
+    i16 106, label %b9
+    i16 108, label %b10
+    i16 110, label %b0
+    i16 112, label %b1
+    i16 114, label %b2
+    i16 116, label %b3
+    i16 118, label %b4
+    i16 120, label %b5
+  ]
+b0:
+  br label %exit
+b1:
+  br label %exit
+b2:
+  br label %exit
+b3:
+  br label %exit
+b4:
+  br label %exit
+b5:
+  br label %exit
+b6:
+  br label %exit
+b7:
+  br label %exit
+b8:
+  br label %exit
+b9:
+  br label %exit
+b10:
+  br label %exit
+default:
+  br label %exit
+exit:
+  %r = phi i32 [ 11, %b0 ], [ 48, %b1 ], [ 85, %b2 ], [ 122, %b3 ], [ 159, %b4 ], [ 196, %b5 ], [ 233, %b6 ], [ 270, %b7 ], [ 307, %b8 ], [ 344, %b9 ], [ 381, %b10 ], [ 7, %default ]
+  ret i32 %r
+}
+
+define i32 @main() {
+entry:
+  br label %loop8
+
+loop8:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %loop8 ]
+  %s8 = phi i64 [ 0, %entry ], [ %s8.next, %loop8 ]
+  %x8 = trunc i32 %i to i8
+  %r8 = call i32 @sw8(i8 %x8)
+  %w8 = add i32 %i, 1
+  %p8 = mul i32 %r8, %w8
+  %p8.wide = zext i32 %p8 to i64
+  %s8.next = add i64 %s8, %p8.wide
+  %i.next = add i32 %i, 1
+  %done8 = icmp eq i32 %i.next, 256
+  br i1 %done8, label %loop16, label %loop8
+
+loop16:
+  %j = phi i32 [ -300, %loop8 ], [ %j.next, %loop16 ]
+  %s16 = phi i64 [ %s8.next, %loop8 ], [ %s16.next, %loop16 ]
+  %x16 = trunc i32 %j to i16
+  %r16 = call i32 @sw16(i16 %x16)
+  %w16 = add i32 %j, 400
+  %p16 = mul i32 %r16, %w16
+  %p16.wide = zext i32 %p16 to i64
+  %s16.next = add i64 %s16, %p16.wide
+  %j.next = add i32 %j, 1
+  %done16 = icmp eq i32 %j.next, 301
+  br i1 %done16, label %exit, label %loop16
+
+exit:
+  %f = getelementptr inbounds [10 x i8], [10 x i8]* @fmt, i64 0, i64 0
+  call i32 (i8*, ...) @printf(i8* %f, i64 %s16.next)
+  ret i32 0
+}
@@ -0,0 +1,14 @@
+; Two modules that share a linkonce_odr comdat string, as C++ inline-function
+; statics do. Each module is obfuscated on its own (as with --lto thin), then
+; linked; the one copy the linker keeps must still print as plaintext.
+
+$s = comdat any
+
+@s = linkonce_odr constant [6 x i8] c"hello\00", comdat
+
+declare i32 @puts(i8*)
+
+define void @print_a() {
+  call i32 @puts(i8* getelementptr ([6 x i8], [6 x i8]* @s, i64 0, i64 0))
+  ret void
+}
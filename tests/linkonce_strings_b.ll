@@ -0,0 +1,14 @@
+; Second module of the linkonce_strings test (see linkonce_strings_a.ll)
+
+$s = comdat any
+
+@s = linkonce_odr constant [6 x i8] c"hello\00", comdat
+
+declare i32 @puts(i8*)
+declare void @print_a()
+
+define i32 @main() {
+  call void @print_a()
+  call i32 @puts(i8* getelementptr ([6 x i8], [6 x i8]* @s, i64 0, i64 0))
+  ret i32 0
+}
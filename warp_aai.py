@@ -17,13 +17,135 @@ with applicable laws and regulations.
 import argparse
 import subprocess
 import os
+import re
 import sys
 import json
 import time
+import hashlib
+import zlib
+import threading
+from concurrent.futures import ThreadPoolExecutor
 from pathlib import Path
 from datetime import datetime
 import shutil
 
+from warp_size_report import size_report
+
+# Techniques SimpleObfPass can apply, in the order it runs them
+TECHNIQUES = ("strings", "bogus_functions", "rename_globals", "dead_conditionals",
+              "jump_tables")
+METHOD_NAMES = {
+    "strings": "XOR string encryption",
+    "bogus_functions": "Bogus function insertion",
+    "rename_globals": "Private symbol renaming",
+    "dead_conditionals": "Dead conditional branch insertion",
+    "jump_tables": "Encoded switch jump tables",
+}
+# -obf-string-decode strategies; all but eager need the warp_rt runtime
+STRING_DECODE_STRATEGIES = ("eager", "lazy", "blob", "paged", "compressed")
+
+
+def default_cache_dir():
+    """Per-user cache location (honours XDG_CACHE_HOME)"""
+    base = os.environ.get('XDG_CACHE_HOME', os.path.join(os.path.expanduser('~'), '.cache'))
+    return os.path.join(base, 'warp_aai')
+
+
+class ArtifactCache:
+    """Content-addressed store for bitcode artifacts
+    
+    Entries are zlib-compressed files named by the SHA-256 of everything that
+    can influence their contents. The modification time of an entry doubles as
+    its last-use time, so eviction drops the least recently used entries until
+    the store fits in max_bytes.
+    """
+    
+    SUFFIX = '.z'
+    
+    def __init__(self, root, max_bytes, log):
+        self.root = root
+        self.max_bytes = max_bytes
+        self.log = log
+        self.hits = 0
+        self.misses = 0
+        os.makedirs(root, exist_ok=True)
+    
+    @staticmethod
+    def make_key(*parts):
+        """Hash an ordered list of str/bytes parts into a cache key"""
+        h = hashlib.sha256()
+        for part in parts:
+            if isinstance(part, str):
+                part = part.encode('utf-8')
+            # Length-prefix each part so ('ab', 'c') and ('a', 'bc') differ
+            h.update(len(part).to_bytes(8, 'little'))
+            h.update(part)
+        return h.hexdigest()
+    
+    def _entry_path(self, key, name):
+        return os.path.join(self.root, key[:2], f"{key}.{name}{self.SUFFIX}")
+    
+    def get(self, key, name, dest_path, count=True):
+        """Restore an entry to dest_path; returns False on a miss"""
+        entry = self._entry_path(key, name)
+        try:
+            with open(entry, 'rb') as f:
+                data = zlib.decompress(f.read())
+        except (OSError, zlib.error):
+            if count:
+                self.misses += 1
+            return False
+        
+        with open(dest_path, 'wb') as f:
+            f.write(data)
+        os.utime(entry)  # mark as recently used
+        if count:
+            self.hits += 1
+        return True
+    
+    def put(self, key, name, src_path):
+        """Store src_path under key; concurrent writers are safe"""
+        entry = self._entry_path(key, name)
+        os.makedirs(os.path.dirname(entry), exist_ok=True)
+        with open(src_path, 'rb') as f:
+            data = zlib.compress(f.read(), 6)
+        
+        tmp = f"{entry}.{os.getpid()}.tmp"
+        with open(tmp, 'wb') as f:
+            f.write(data)
+        os.replace(tmp, entry)
+    
+    def evict(self):
+        """Drop least recently used entries until the store fits max_bytes"""
+        entries = []
+        total = 0
+        for dirpath, _, filenames in os.walk(self.root):
+            for fn in filenames:
+                if not fn.endswith(self.SUFFIX):
+                    continue
+                path = os.path.join(dirpath, fn)
+                try:
+                    st = os.stat(path)
+                except OSError:
+                    continue
+                entries.append((st.st_mtime, st.st_size, path))
+                total += st.st_size
+        
+        if total <= self.max_bytes:
+            return
+        
+        entries.sort()
+        for _, size, path in entries:
+            if total <= self.max_bytes:
+                break
+            try:
+                os.remove(path)
+                total -= size
+                self.log(f"Cache evicted: {os.path.basename(path)}", "DEBUG")
+            except OSError:
+                pass
+
+
 class WarpAAIToolchain:
     """Main toolchain orchestrator for the warp_aai obfuscation pipeline"""
     
@@ -31,6 +153,30 @@ class WarpAAIToolchain:
         self.verbose = False
         self.temp_files = []
         self.start_time = time.time()
+        self.cache = None
+        self.cflags = ['-O1']  # Light optimization to generate cleaner IR
+        self.ldflags = []
+        self.profile_inputs = []  # profiles read by cflags; part of the bitcode key
+        self.bitcode_keys = []
+        self.tool_versions = {}
+        self.partitions = []
+        # Compiler processes share these slots, so variants and partitions
+        # together never run more than --jobs at once
+        self.job_slots = threading.BoundedSemaphore(os.cpu_count() or 1)
+        self.lto = "full"
+        self.lto_jobs = 1
+        self.time_trace = None
+        self.remarks_file = None
+        self.remarks_format = "yaml"
+        self.estimate_overhead = False
+        self.techniques = []
+        self.string_decode = "eager"
+        self.runtime_lib = None
+        self.string_profile_generate = False
+        self.string_profile = None  # warp_rt string profile to build with
+        self.string_predecode = False
+        self.export_list = None  # symbols to keep external; the rest is internalized
+        self.shared = False
         
     def log(self, message, level="INFO"):
         """Log messages with timestamp"""
@@ -63,9 +209,33 @@ class WarpAAIToolchain:
             
         return True
     
+    def tool_version(self, tool):
+        """Full version banner of an LLVM tool (part of every cache key)"""
+        if tool not in self.tool_versions:
+            result = subprocess.run([tool, '--version'], capture_output=True, text=True)
+            self.tool_versions[tool] = result.stdout
+        return self.tool_versions[tool]
+    
+    def bitcode_cache_key(self, source):
+        """Key a TU by its preprocessed text, compiler version and flags"""
+        cmd = ['clang', '-E', source] + self.cflags
+        result = subprocess.run(cmd, capture_output=True)
+        if result.returncode != 0:
+            raise RuntimeError(f"Preprocessing failed for {source}:\n"
+                               f"{result.stderr.decode(errors='replace')}")
+        
+        profiles = []
+        for path in self.profile_inputs:
+            with open(path, 'rb') as f:
+                profiles.append(f.read())
+        return ArtifactCache.make_key(
+            'bitcode-v1', result.stdout, self.tool_version('clang'),
+            '\0'.join(self.cflags), *profiles)
+    
     def compile_to_bitcode(self, source_files, output_dir):
         """Compile C/C++ source files to LLVM bitcode"""
         bitcode_files = []
+        self.bitcode_keys = []
         
         for source in source_files:
             if not os.path.exists(source):
@@ -75,17 +245,22 @@ class WarpAAIToolchain:
             base_name = Path(source).stem
             bc_file = os.path.join(output_dir, f"{base_name}.bc")
             
-            self.log(f"Compiling {source} -> {bc_file}")
-            
-            # Compile to bitcode
-            cmd = [
-                'clang', '-emit-llvm', '-c', '-o', bc_file, source,
-                '-O1',  # Light optimization to generate cleaner IR
-            ]
-            
-            result = subprocess.run(cmd, capture_output=True, text=True)
-            if result.returncode != 0:
-                raise RuntimeError(f"Compilation failed for {source}:\n{result.stderr}")
+            key = self.bitcode_cache_key(source) if self.cache else None
+            self.bitcode_keys.append(key)
+            if key and self.cache.get(key, 'bc', bc_file):
+                self.log(f"Reusing cached bitcode for {source}")
+            else:
+                self.log(f"Compiling {source} -> {bc_file}")
+                
+                # Compile to bitcode
+                cmd = ['clang', '-emit-llvm', '-c', '-o', bc_file, source] + self.cflags
+                
+                result = subprocess.run(cmd, capture_output=True, text=True)
+                if result.returncode != 0:
+                    raise RuntimeError(f"Compilation failed for {source}:\n{result.stderr}")
+                
+                if key:
+                    self.cache.put(key, 'bc', bc_file)
             
             bitcode_files.append(bc_file)
             self.temp_files.append(bc_file)
@@ -110,22 +285,107 @@ class WarpAAIToolchain:
         self.temp_files.append(output_file)
         return output_file
     
-    def run_obfuscation_pass(self, input_bc, output_bc, pass_lib, xor_key, bogus_count, cycles):
-        """Run the custom obfuscation pass"""
-        self.log(f"Running obfuscation pass: {input_bc} -> {output_bc}")
-        self.log(f"Parameters: xor_key={xor_key}, bogus_count={bogus_count}, cycles={cycles}")
-        
-        # Construct opt command
-        cmd = [
-            'opt',
-            '-load', pass_lib,
+    def pass_arguments(self, xor_key, bogus_count, cycles, seed=0):
+        """opt arguments selecting and configuring the obfuscation pass"""
+        args = [
+            '-enable-new-pm=0',  # SimpleObfPass is a legacy-PM pass
             '-simple-obf',
             f'-xor-key={xor_key}',
             f'-bogus-count={bogus_count}',
-            f'-cycles={cycles}',
-            input_bc,
-            '-o', output_bc
+            f'-obf-cycles={cycles}',
+            f'-obf-seed={seed}',
         ]
+        if self.techniques:
+            args.append(f"-obf-techniques={','.join(self.techniques)}")
+        if self.estimate_overhead:
+            args.append('-obf-estimate-overhead')
+        if self.string_decode != "eager":
+            args.append(f'-obf-string-decode={self.string_decode}')
+        if self.string_profile_generate:
+            args.append('-obf-string-profile-generate')
+        if self.string_profile:
+            args.append(f'-obf-string-profile-use={os.path.abspath(self.string_profile)}')
+        if self.string_predecode:
+            args.append('-obf-string-predecode')
+        if self.export_list:
+            args.append(f'-obf-export-list={os.path.abspath(self.export_list)}')
+        return args
+    
+    @staticmethod
+    def default_runtime_lib(pass_lib):
+        """libwarp_rt.a is built next to the pass plugin"""
+        return os.path.join(os.path.dirname(os.path.abspath(pass_lib)), 'libwarp_rt.a')
+    
+    def needs_runtime(self):
+        return ((self.string_decode != "eager" or self.string_profile_generate) and
+                (not self.techniques or "strings" in self.techniques))
+    
+    def runtime_inputs(self):
+        """Link inputs for the warp_rt runtime, when the decode strategy calls it"""
+        if not self.runtime_lib or not self.needs_runtime():
+            return []
+        # The pre-decode thread needs pthreads
+        return [self.runtime_lib, '-pthread'] if self.string_predecode else [self.runtime_lib]
+    
+    def obfuscation_cache_key(self, pass_lib, pass_args, input_keys):
+        """Key an obfuscated module by its inputs, plugin build and pass options
+        
+        The plugin is identified by a hash of its contents, so rebuilding it
+        with different code invalidates every obfuscated entry.
+        """
+        if not self.cache or None in input_keys:
+            return None
+        
+        with open(pass_lib, 'rb') as f:
+            plugin_id = hashlib.sha256(f.read()).hexdigest()
+        inputs = []
+        for path in (self.string_profile, self.export_list):
+            if path:
+                with open(path, 'rb') as f:
+                    inputs.append(f.read())
+        
+        return ArtifactCache.make_key(
+            'obfuscated-v1', '\0'.join(input_keys),
+            self.tool_version('llvm-link'), self.tool_version('opt'),
+            plugin_id, '\0'.join(pass_args), *inputs)
+    
+    def run_obfuscation_pass(self, input_bc, output_bc, pass_lib, xor_key, bogus_count, cycles,
+                             seed=0, extra_args=(), input_keys=None, telemetry_file=None):
+        """Run the custom obfuscation pass"""
+        pass_args = self.pass_arguments(xor_key, bogus_count, cycles, seed) + list(extra_args)
+        if telemetry_file is None:
+            telemetry_file = os.path.join(os.path.dirname(output_bc), "warp_pass_telemetry.json")
+        if input_keys is None:
+            input_keys = self.bitcode_keys
+        
+        # Traces and remarks only come from a real run, so skip the cache
+        key = None
+        if not (self.time_trace or self.remarks_file):
+            key = self.obfuscation_cache_key(pass_lib, pass_args, input_keys)
+        if key and self.cache.get(key, 'bc', output_bc):
+            self.cache.get(key, 'telemetry', telemetry_file, count=False)
+            self.log(f"Reusing cached obfuscated module: {output_bc}")
+            self.temp_files.append(output_bc)
+            return output_bc
+        
+        self.log(f"Running obfuscation pass: {input_bc} -> {output_bc}")
+        self.log(f"Parameters: xor_key={xor_key}, bogus_count={bogus_count}, "
+                 f"cycles={cycles}, seed={seed}")
+        
+        # Construct opt command
+        cmd = (['opt', '-load', pass_lib] + pass_args +
+               [f'-obf-telemetry-file={telemetry_file}', input_bc, '-o', output_bc])
+        if self.time_trace:
+            trace = self.per_module_path(self.time_trace, input_bc)
+            cmd[-3:-3] = ['-time-trace', f'-time-trace-file={trace}']
+        if self.remarks_file:
+            remarks = self.per_module_path(self.remarks_file, input_bc)
+            cmd[-3:-3] = [f'-pass-remarks-output={remarks}',
+                          f'-pass-remarks-format={self.remarks_format}',
+                          '-pass-remarks-filter=simple-obf']
+        if self.verbose:
+            cmd[-3:-3] = ['-pass-remarks=simple-obf', '-pass-remarks-missed=simple-obf',
+                          '-pass-remarks-analysis=simple-obf']
         
         # Run the pass
         result = subprocess.run(cmd, capture_output=True, text=True)
@@ -133,20 +393,92 @@ class WarpAAIToolchain:
         if result.returncode != 0:
             raise RuntimeError(f"Obfuscation pass failed:\n{result.stderr}")
         
-        # Log pass output (contains telemetry and debug info)
+        # Pass output is remarks (verbose runs) and warnings
         if result.stderr:
-            self.log("Pass output:")
+            self.log("Pass output:", "DEBUG")
             for line in result.stderr.strip().split('\n'):
                 if line.strip():
-                    self.log(f"  {line}")
+                    self.log(f"  {line}", "DEBUG")
+        
+        if key:
+            self.cache.put(key, 'bc', output_bc)
+            if os.path.exists(telemetry_file):
+                self.cache.put(key, 'telemetry', telemetry_file)
         
         self.temp_files.append(output_bc)
         return output_bc
     
-    def compile_to_native(self, input_bc, output_binary, target="linux"):
-        """Compile obfuscated bitcode to native binary"""
-        self.log(f"Compiling to native binary: {input_bc} -> {output_binary}")
+    def per_module_path(self, path, input_bc):
+        """Output path for one opt run (one file per module with ThinLTO)"""
+        if self.lto != "thin":
+            return path
+        path = Path(path)
+        return str(path.with_name(f"{path.stem}.{Path(input_bc).stem}{path.suffix}"))
+    
+    @staticmethod
+    def module_seed(seed, bitcode_file):
+        """Stable per-module seed derived from the global seed and module name"""
+        digest = ArtifactCache.make_key('seed', str(seed), Path(bitcode_file).name)
+        return int(digest[:16], 16)
+    
+    def obfuscate_thin_modules(self, bitcode_files, pass_lib, args):
+        """Obfuscate each translation unit separately for a ThinLTO link
         
+        Modules are processed in parallel and written as ThinLTO bitcode
+        carrying a module summary. Each one gets its own seed and records its
+        obfuscation state in metadata, so functions the thin link later
+        imports into other modules are not obfuscated again.
+        """
+        jobs = []
+        for bc_file, input_key in zip(bitcode_files, self.bitcode_keys):
+            stem = os.path.splitext(bc_file)[0]
+            jobs.append((bc_file, f"{stem}.obf.bc", f"{stem}.telemetry.json",
+                         self.module_seed(args.seed, bc_file), input_key))
+        
+        with ThreadPoolExecutor(max_workers=max(1, min(args.jobs, len(jobs)))) as pool:
+            futures = [
+                pool.submit(self.run_obfuscation_pass, bc_file, out_bc, pass_lib,
+                            args.xor_key, args.bogus_count, args.cycles, seed,
+                            ['-thinlto-bc'], [input_key], telemetry)
+                for bc_file, out_bc, telemetry, seed, input_key in jobs
+            ]
+            for future in futures:
+                future.result()
+        
+        self.temp_files.extend(telemetry for _, _, telemetry, _, _ in jobs)
+        return [out_bc for _, out_bc, _, _, _ in jobs], [telemetry for _, _, telemetry, _, _ in jobs]
+    
+    def split_module(self, input_bc, jobs):
+        """Split the obfuscated module into partitions for parallel codegen
+        
+        Uses llvm-split, the same module splitter -flto-jobs uses for full
+        LTO. Local symbols referenced across partitions are promoted to
+        hidden externals so that the partitions link back together.
+        """
+        prefix = os.path.splitext(input_bc)[0] + ".part"
+        self.log(f"Splitting {input_bc} into {jobs} codegen partitions")
+        
+        cmd = ['llvm-split', f'-j={jobs}', '-o', prefix, input_bc]
+        result = subprocess.run(cmd, capture_output=True, text=True)
+        if result.returncode != 0:
+            raise RuntimeError(f"Module splitting failed:\n{result.stderr}")
+        
+        # llvm-split writes <prefix>N; clang only reads them as IR with a .bc
+        # extension and would otherwise pass them to the linker
+        self.partitions = []
+        for i in range(jobs):
+            os.replace(f"{prefix}{i}", f"{prefix}{i}.bc")
+            self.partitions.append(f"{prefix}{i}.bc")
+        self.temp_files.extend(self.partitions)
+        return self.partitions
+    
+    def run_codegen(self, cmd):
+        """Run one compiler process in a --jobs slot"""
+        with self.job_slots:
+            return subprocess.run(cmd, capture_output=True, text=True)
+    
+    def native_compiler(self, target):
+        """Compiler driver and target flags for the requested platform"""
         if target == "windows":
             # Cross-compile for Windows using mingw
             compiler = "x86_64-w64-mingw32-clang"
@@ -156,24 +488,206 @@ class WarpAAIToolchain:
         else:
             compiler = "clang"
         
-        cmd = [compiler, input_bc, '-o', output_binary]
+        flags = ['-fPIC'] if self.shared else []
         
         # Add target-specific flags
         if target == "windows" and compiler.endswith("mingw32-clang"):
-            cmd.extend(['-target', 'x86_64-w64-mingw32'])
+            flags.extend(['-target', 'x86_64-w64-mingw32'])
         
-        result = subprocess.run(cmd, capture_output=True, text=True)
+        return compiler, flags
+    
+    def retarget(self, input_bc, march):
+        """Copy of input_bc whose functions are compiled for -march
+        
+        clang records the CPU a TU was compiled for in per-function
+        "target-cpu" and "target-features" attributes, and those override
+        -march when the bitcode reaches codegen. Dropping them leaves the
+        choice to the -march of each variant.
+        """
+        output = f"{os.path.splitext(input_bc)[0]}.{march}.bc"
+        result = subprocess.run(['llvm-dis', input_bc, '-o', '-'], capture_output=True, text=True)
+        if result.returncode != 0:
+            raise RuntimeError(f"Disassembling {input_bc} failed:\n{result.stderr}")
+        ir = re.sub(r' ?"target-(?:cpu|features)"="[^"]*"', '', result.stdout)
+        result = subprocess.run(['llvm-as', '-', '-o', output], input=ir,
+                                capture_output=True, text=True)
+        if result.returncode != 0:
+            raise RuntimeError(f"Retargeting {input_bc} for {march} failed:\n{result.stderr}")
+        self.temp_files.append(output)
+        return output
+    
+    def compile_to_native(self, input_bc, output_binary, target="linux", march=None):
+        """Compile obfuscated bitcode to native binary"""
+        self.log(f"Compiling to native binary: {input_bc} -> {output_binary}")
+        
+        compiler, flags = self.native_compiler(target)
+        if march:
+            flags.append(f'-march={march}')
+        
+        if self.partitions:
+            return self.compile_partitions(compiler, flags, output_binary, march)
+        
+        inputs = input_bc if isinstance(input_bc, list) else [input_bc]
+        if march:
+            inputs = [self.retarget(bc, march) for bc in inputs]
+        if self.lto == "thin":
+            flags.extend(['-flto=thin', '-fuse-ld=lld', f'-Wl,--thinlto-jobs={self.lto_jobs}'])
+        
+        cmd = ([compiler] + inputs + self.runtime_inputs() + ['-o', output_binary] + flags +
+               self.ldflags)
+        
+        result = self.run_codegen(cmd)
         
         if result.returncode != 0:
             raise RuntimeError(f"Native compilation failed:\n{result.stderr}")
         
         return output_binary
     
-    def parse_telemetry(self, working_dir):
+    def compile_partitions(self, compiler, flags, output_binary, march=None):
+        """Compile split partitions to objects in parallel, then link them"""
+        # Objects live next to the partitions; one set per output variant
+        base = os.path.basename(output_binary)
+        objects = [os.path.join(os.path.dirname(partition), f"{base}.part{i}.o")
+                   for i, partition in enumerate(self.partitions)]
+        self.temp_files.extend(objects)
+        
+        def compile_one(partition, obj):
+            if march:
+                partition = self.retarget(partition, march)
+            cmd = [compiler, '-c', partition, '-o', obj] + flags
+            result = self.run_codegen(cmd)
+            if result.returncode != 0:
+                raise RuntimeError(f"Codegen failed for {partition}:\n{result.stderr}")
+        
+        with ThreadPoolExecutor(max_workers=len(self.partitions)) as pool:
+            futures = [pool.submit(compile_one, partition, obj)
+                       for partition, obj in zip(self.partitions, objects)]
+            for future in futures:
+                future.result()
+        
+        cmd = ([compiler] + objects + self.runtime_inputs() + ['-o', output_binary] + flags +
+               self.ldflags)
+        result = self.run_codegen(cmd)
+        if result.returncode != 0:
+            raise RuntimeError(f"Linking partitions failed:\n{result.stderr}")
+        
+        return output_binary
+    
+    @staticmethod
+    def variant_output_name(output_binary, march):
+        """Per-target output name: app.exe -> app-x86-64-v3.exe"""
+        path = Path(output_binary)
+        return str(path.with_name(f"{path.stem}-{march}{path.suffix}"))
+    
+    def compile_variants(self, input_bc, output_binary, target, marches, jobs):
+        """Run codegen for several -march targets in parallel
+        
+        Every variant is compiled from the same obfuscated module, so all of
+        them carry identical protection. Returns (march, path) pairs.
+        """
+        variants = [(march, self.variant_output_name(output_binary, march))
+                    for march in marches]
+        
+        with ThreadPoolExecutor(max_workers=max(1, min(jobs, len(variants)))) as pool:
+            futures = [pool.submit(self.compile_to_native, input_bc, path, target, march)
+                       for march, path in variants]
+            for future in futures:
+                future.result()  # re-raise the first codegen failure
+        
+        # Identical binaries mean -march never reached codegen, or that the
+        # program has nothing the newer targets could use
+        seen = {}
+        for march, path in variants:
+            with open(path, 'rb') as f:
+                digest = hashlib.sha256(f.read()).hexdigest()
+            if digest in seen:
+                self.log(f"Variants {seen[digest]} and {march} are identical", "WARNING")
+            else:
+                seen[digest] = march
+        
+        return variants
+    
+    def profile_flags(self, args, work_dir):
+        """clang flags for --profile-generate, --profile-use and --sample-profile
+        
+        Profiles are applied when the sources are compiled to bitcode, before
+        the pass renames anything, so they match by source names. A profile
+        collected from an earlier obfuscated build is first mapped back to
+        source names with that build's --profile-remap file.
+        """
+        flags = []
+        if args.profile_generate:
+            flags.append('-fprofile-instr-generate')
+            self.ldflags.append('-fprofile-instr-generate')
+        for profile, kind in ((args.profile_use, 'instr'), (args.sample_profile, 'sample')):
+            if not profile:
+                continue
+            if args.profile_remap:
+                profile = self.remap_profile(profile, kind, args.profile_remap, work_dir)
+            self.profile_inputs.append(profile)
+            flags.append(f'-fprofile-{kind}-use={os.path.abspath(profile)}')
+            if kind == 'sample':
+                flags.append('-gline-tables-only')
+        return flags
+    
+    def remap_profile(self, profile, kind, remap_file, work_dir):
+        """Rewrite obfuscated names in a profile to source names"""
+        reverse = os.path.join(work_dir, "profile_remap.reverse.txt")
+        with open(remap_file) as f, open(reverse, 'w') as out:
+            for line in f:
+                parts = line.split()
+                if len(parts) == 2 and not line.startswith('#'):
+                    out.write(f"{parts[1]} {parts[0]}\n")
+        remapped = os.path.join(work_dir, f"remapped.{kind}.profdata")
+        self.log(f"Remapping {profile} with {remap_file} -> {remapped}")
+        cmd = ['llvm-profdata', 'merge', f'-{kind}', f'-remapping-file={reverse}',
+               profile, '-o', remapped]
+        result = subprocess.run(cmd, capture_output=True, text=True)
+        if result.returncode != 0:
+            raise RuntimeError(f"Profile remapping failed:\n{result.stderr}")
+        self.temp_files.extend([reverse, remapped])
+        return remapped
+    
+    @staticmethod
+    def write_profile_remap(remap, output_binary):
+        """<output>.profremap: original -> obfuscated names of this build, in
+        the llvm-profdata merge -remapping-file format. remap is the
+        telemetry's profile_remap, keyed by obfuscated name."""
+        path = f"{output_binary}.profremap"
+        with open(path, 'w') as f:
+            f.write(f"# Profile name remapping for {Path(output_binary).name}\n"
+                    "# <original> <obfuscated>; pass to --profile-remap with a profile "
+                    "collected from this build\n")
+            for obfuscated, original in remap.items():
+                f.write(f"{original} {obfuscated}\n")
+        return path
+    
+    def split_debug_info(self, binary):
+        """Move the DWARF of binary into <binary>.debug and strip it
+        
+        The stripped binary keeps a .gnu_debuglink to the debug file, so
+        llvm-symbolizer, gdb and profilers that look it up next to the binary
+        or under a debug directory report source lines and original names
+        for its addresses.
+        """
+        objcopy = shutil.which('llvm-objcopy') or shutil.which('objcopy')
+        if not objcopy:
+            raise RuntimeError("--split-debug needs llvm-objcopy or objcopy")
+        debug_file = f"{binary}.debug"
+        for cmd in ([objcopy, '--only-keep-debug', binary, debug_file],
+                    [objcopy, '--strip-all', f'--add-gnu-debuglink={debug_file}', binary]):
+            result = subprocess.run(cmd, capture_output=True, text=True)
+            if result.returncode != 0:
+                raise RuntimeError(f"Splitting debug info failed:\n{result.stderr}")
+        self.log(f"Split debug info: {binary} -> {debug_file}")
+        return debug_file
+    
+    def parse_telemetry(self, working_dir, telemetry_file=None):
         """Parse telemetry data from the pass"""
-        telemetry_file = os.path.join(working_dir, "warp_pass_telemetry.json")
+        if telemetry_file is None and working_dir is not None:
+            telemetry_file = os.path.join(working_dir, "warp_pass_telemetry.json")
         
-        if os.path.exists(telemetry_file):
+        if telemetry_file and os.path.exists(telemetry_file):
             try:
                 with open(telemetry_file, 'r') as f:
                     return json.load(f)
@@ -189,7 +703,50 @@ class WarpAAIToolchain:
             "bogus_count_requested": 0
         }
     
-    def generate_report(self, input_files, output_file, telemetry, parameters):
+    def merge_telemetry(self, telemetry_files):
+        """Sum the per-module telemetry of a ThinLTO build"""
+        # Settings are identical across modules; cycles are per module
+        settings = ("cycles_completed", "xor_key", "bogus_count_requested", "seed")
+        merged = self.parse_telemetry(None)
+        for path in telemetry_files:
+            data = self.parse_telemetry(None, path)
+            for field, value in data.items():
+                if field in settings:
+                    merged[field] = value
+                elif field == "peak_rss_bytes":
+                    merged[field] = max(merged.get(field, 0), value)
+                elif isinstance(value, (int, float)):
+                    merged[field] = merged.get(field, 0) + value
+                elif isinstance(value, dict):
+                    bucket = merged.setdefault(field, {})
+                    for name, amount in value.items():
+                        if isinstance(amount, (int, float)):
+                            bucket[name] = bucket.get(name, 0) + amount
+                        else:
+                            bucket[name] = amount  # symbol maps
+                elif isinstance(value, list):
+                    merged.setdefault(field, []).extend(value)
+        return merged
+    
+    def export_telemetry(self, telemetry_files, telemetry_dir, output_binary):
+        """Copy per-module telemetry under unique names for warp_telemetry_agg.py"""
+        os.makedirs(telemetry_dir, exist_ok=True)
+        tag = f"{Path(output_binary).stem}_{os.getpid()}_{int(time.time())}"
+        for path in telemetry_files:
+            if os.path.exists(path):
+                dest = os.path.join(telemetry_dir,
+                                    f"warp_pass_telemetry_{tag}_{Path(path).stem}.json")
+                shutil.copy2(path, dest)
+                self.log(f"Telemetry exported: {dest}", "DEBUG")
+    
+    @staticmethod
+    def rank_overhead(telemetry):
+        """Per-function overhead estimates, most expensive first"""
+        def weight(entry):
+            return entry["latency_delta"] * entry.get("entry_count", 1)
+        return sorted(telemetry.get("overhead", []), key=weight, reverse=True)
+    
+    def generate_report(self, input_files, output_file, telemetry, parameters, variants=None):
         """Generate final JSON report"""
         # Get output file size
         output_size = os.path.getsize(output_file) if os.path.exists(output_file) else 0
@@ -221,10 +778,7 @@ class WarpAAIToolchain:
                 "bogus_functions_requested": telemetry.get("bogus_count_requested", 0)
             },
             "methods_applied": [
-                "XOR string encryption",
-                "Bogus function insertion",
-                "Private symbol renaming",
-                "Dead conditional branch insertion"
+                METHOD_NAMES[t] for t in parameters.get("techniques", TECHNIQUES)
             ],
             "limitations": [
                 "Educational MVP - not production ready",
@@ -235,6 +789,16 @@ class WarpAAIToolchain:
             "notes": "This is an educational tool demonstrating basic LLVM-based obfuscation techniques."
         }
         
+        if variants:
+            report["variants"] = [
+                {
+                    "march": march,
+                    "path": os.path.abspath(path),
+                    "size_bytes": os.path.getsize(path) if os.path.exists(path) else 0
+                }
+                for march, path in variants
+            ]
+        
         return report
     
     def cleanup(self):
@@ -271,34 +835,161 @@ class WarpAAIToolchain:
                 "bogus_count": args.bogus_count,
                 "cycles": args.cycles,
                 "target": args.target,
+                "march": args.march,
+                "codegen_jobs": args.codegen_jobs,
+                "lto": args.lto,
+                "seed": args.seed,
+                "techniques": args.techniques or list(TECHNIQUES),
+                "string_decode": args.string_decode,
+                "profile_generate": args.profile_generate,
+                "profile_use": args.profile_use,
+                "sample_profile": args.sample_profile,
+                "split_debug": args.split_debug,
+                "string_profile_generate": args.string_profile_generate,
+                "string_profile_use": args.string_profile_use,
+                "string_predecode": args.string_predecode,
+                "shared": args.shared,
+                "export_list": args.export_list,
                 "pass_library": os.path.abspath(args.pass_lib)
             }
             
+            if not args.no_cache:
+                self.cache = ArtifactCache(args.cache_dir,
+                                           args.cache_max_size * 1024 * 1024,
+                                           self.log)
+            
+            self.shared = args.shared
+            if args.shared:
+                self.cflags = self.cflags + ['-fPIC']
+                self.ldflags.append('-shared')
+            self.cflags = self.cflags + self.profile_flags(args, work_dir)
+            if args.split_debug:
+                self.cflags = self.cflags + ['-g']
+            
             # Step 1: Compile to bitcode
             self.log("=== Step 1: Compiling to LLVM bitcode ===")
             bitcode_files = self.compile_to_bitcode(args.input_files, work_dir)
             
-            # Step 2: Link bitcode
-            self.log("=== Step 2: Linking bitcode ===")
-            linked_bc = os.path.join(work_dir, "linked.bc")
-            self.link_bitcode(bitcode_files, linked_bc)
+            self.lto = args.lto
+            self.lto_jobs = args.jobs
+            self.job_slots = threading.BoundedSemaphore(max(1, args.jobs))
+            self.time_trace = args.time_trace
+            self.remarks_file = args.remarks_file
+            self.remarks_format = args.remarks_format
+            self.estimate_overhead = args.overhead_report or args.max_overhead is not None
+            self.techniques = args.techniques
+            self.string_decode = args.string_decode
+            self.string_profile_generate = args.string_profile_generate
+            self.string_predecode = args.string_predecode
+            self.string_profile = args.string_profile_use
+            if self.string_profile and not os.path.exists(self.string_profile):
+                self.log(f"String profile not found: {self.string_profile}", "ERROR")
+                return 1
+            self.export_list = args.export_list
+            if self.export_list and not os.path.exists(self.export_list):
+                self.log(f"Export list not found: {self.export_list}", "ERROR")
+                return 1
+            if self.export_list and args.lto == "thin":
+                # Each ThinLTO module only sees its own uses
+                self.log("--export-list needs the whole program in one module; "
+                         "use --lto full", "ERROR")
+                return 1
+            self.runtime_lib = args.runtime_lib or self.default_runtime_lib(args.pass_lib)
+            if self.needs_runtime() and not os.path.exists(self.runtime_lib):
+                self.log(f"Runtime library not found: {self.runtime_lib} "
+                         f"(needed by --string-decode {self.string_decode} and "
+                         f"--string-profile-generate)", "ERROR")
+                return 1
+            telemetry_files = None
             
-            # Step 3: Run obfuscation pass
-            self.log("=== Step 3: Running obfuscation pass ===")
-            obfuscated_bc = os.path.join(work_dir, "obfuscated.bc")
-            self.run_obfuscation_pass(
-                linked_bc, obfuscated_bc, args.pass_lib,
-                args.xor_key, args.bogus_count, args.cycles
-            )
+            if args.lto == "thin":
+                # Step 2+3: Obfuscate each module for a ThinLTO link
+                self.log("=== Step 2: Skipping bitcode link (ThinLTO) ===")
+                self.log("=== Step 3: Running obfuscation pass per module ===")
+                obfuscated_bc, telemetry_files = self.obfuscate_thin_modules(
+                    bitcode_files, args.pass_lib, args)
+            else:
+                # Step 2: Link bitcode
+                self.log("=== Step 2: Linking bitcode ===")
+                linked_bc = os.path.join(work_dir, "linked.bc")
+                self.link_bitcode(bitcode_files, linked_bc)
+                
+                # Step 3: Run obfuscation pass
+                self.log("=== Step 3: Running obfuscation pass ===")
+                obfuscated_bc = os.path.join(work_dir, "obfuscated.bc")
+                self.run_obfuscation_pass(
+                    linked_bc, obfuscated_bc, args.pass_lib,
+                    args.xor_key, args.bogus_count, args.cycles, args.seed
+                )
             
             # Step 4: Compile to native
             self.log("=== Step 4: Compiling to native binary ===")
-            self.compile_to_native(obfuscated_bc, args.output, args.target)
+            baseline = None
+            if args.size_report:
+                # Same codegen settings, unobfuscated input; before any split
+                baseline_bc = bitcode_files if args.lto == "thin" else linked_bc
+                march = args.march[0] if args.march else None
+                baseline = os.path.join(work_dir, Path(args.output).name + ".baseline")
+                self.compile_to_native(baseline_bc, baseline, args.target, march)
+                self.temp_files.append(baseline)
+            if args.codegen_jobs > 1:
+                if args.lto == "thin":
+                    self.log("--codegen-jobs is ignored with --lto thin; "
+                             "ThinLTO backends already run in parallel", "WARNING")
+                else:
+                    self.split_module(obfuscated_bc, args.codegen_jobs)
+            
+            variants = None
+            output_file = args.output
+            if len(args.march) > 1:
+                variants = self.compile_variants(obfuscated_bc, args.output, args.target,
+                                                 args.march, args.jobs)
+                output_file = variants[0][1]
+            else:
+                march = args.march[0] if args.march else None
+                self.compile_to_native(obfuscated_bc, args.output, args.target, march)
             
             # Step 5: Parse telemetry and generate report
             self.log("=== Step 5: Generating report ===")
-            telemetry = self.parse_telemetry(work_dir)
-            report = self.generate_report(args.input_files, args.output, telemetry, parameters)
+            if telemetry_files is not None:
+                telemetry = self.merge_telemetry(telemetry_files)
+            else:
+                telemetry = self.parse_telemetry(work_dir)
+                telemetry_files = [os.path.join(work_dir, "warp_pass_telemetry.json")]
+            if args.telemetry_dir:
+                self.export_telemetry(telemetry_files, args.telemetry_dir, args.output)
+            report = self.generate_report(args.input_files, output_file, telemetry,
+                                          parameters, variants)
+            if baseline:
+                records = [self.parse_telemetry(None, path) for path in telemetry_files]
+                report["size_impact"] = size_report(baseline, output_file, records)
+            if telemetry.get("profile_remap"):
+                report["profile_remap"] = self.write_profile_remap(
+                    telemetry["profile_remap"], args.output)
+            if telemetry.get("string_profile"):
+                report["string_profile"] = telemetry["string_profile"]
+            if args.split_debug:
+                # After the size report, which reads the symbol table
+                binaries = [path for _, path in variants] if variants else [args.output]
+                report["debug_files"] = [self.split_debug_info(path) for path in binaries]
+                report["output"]["size_bytes"] = os.path.getsize(output_file)
+                for variant in report.get("variants", []):
+                    variant["size_bytes"] = os.path.getsize(variant["path"])
+            overhead = []
+            over_budget = []
+            if self.estimate_overhead:
+                overhead = self.rank_overhead(telemetry)
+                report["overhead"] = overhead
+                if args.max_overhead is not None:
+                    over_budget = [entry for entry in overhead
+                                   if entry["latency_delta"] > args.max_overhead]
+            if self.cache:
+                report["cache"] = {
+                    "directory": os.path.abspath(self.cache.root),
+                    "hits": self.cache.hits,
+                    "misses": self.cache.misses
+                }
+                self.cache.evict()
             
             # Write report file
             report_file = f"warp_report_{int(time.time())}.json"
@@ -308,13 +999,35 @@ class WarpAAIToolchain:
             # Print summary
             self.log("=== Obfuscation Complete ===")
             self.log(f"Input files: {len(args.input_files)}")
-            self.log(f"Output binary: {args.output} ({report['output']['size_bytes']} bytes)")
+            if variants:
+                for variant in report["variants"]:
+                    self.log(f"Output binary [{variant['march']}]: {variant['path']} "
+                             f"({variant['size_bytes']} bytes)")
+            else:
+                self.log(f"Output binary: {args.output} ({report['output']['size_bytes']} bytes)")
             self.log(f"Strings obfuscated: {telemetry.get('strings_obf_count', 0)}")
             self.log(f"Fake functions added: {telemetry.get('fake_funcs_inserted', 0)}")
             self.log(f"Cycles completed: {telemetry.get('cycles_completed', 0)}")
+            if "profile_remap" in report:
+                self.log(f"Profile name map: {report['profile_remap']}")
+            if baseline:
+                impact = report["size_impact"]
+                self.log(f"Size delta vs baseline: {impact['totals']['section_delta']:+d} bytes")
+                for technique, delta in impact["by_technique"].items():
+                    self.log(f"  {technique}: {delta:+d} bytes")
+            if self.estimate_overhead:
+                self.log(f"Estimated per-call overhead ({len(overhead)} functions):")
+                for entry in overhead[:10]:
+                    calls = f", {entry['entry_count']} calls" if "entry_count" in entry else ""
+                    self.log(f"  {entry['function']}: latency {entry['latency_delta']:+.1f}, "
+                             f"throughput {entry['throughput_delta']:+.1f}{calls}")
+            for entry in over_budget:
+                self.log(f"{entry['function']}: estimated latency overhead "
+                         f"{entry['latency_delta']:.1f} exceeds --max-overhead "
+                         f"{args.max_overhead}", "ERROR")
             self.log(f"Report saved: {report_file}")
             
-            return 0
+            return 1 if over_budget else 0
             
         except Exception as e:
             self.log(f"Error: {e}", "ERROR")
@@ -336,6 +1049,7 @@ Examples:
   %(prog)s example.c --pass-lib build/lib/libSimpleObfPass.so
   %(prog)s src/*.c --xor-key 42 --bogus-count 5 --cycles 2 --out my_app
   %(prog)s test.c --target windows --out test.exe --verbose
+  %(prog)s src/*.c --march x86-64-v2,x86-64-v3,x86-64-v4 --out my_app
 
 EDUCATIONAL USE ONLY - Do not use for malicious purposes.
         """
@@ -362,13 +1076,105 @@ EDUCATIONAL USE ONLY - Do not use for malicious purposes.
     parser.add_argument('--target', choices=['linux', 'windows'], default='linux',
                       help='Target platform (default: linux)')
     
+    parser.add_argument('--march', type=lambda v: [m for m in v.split(',') if m], default=[],
+                      help='Comma-separated -march values; several values build one '
+                           'binary per target from the same obfuscated module '
+                           '(e.g. x86-64-v2,x86-64-v3,x86-64-v4)')
+    
+    parser.add_argument('--jobs', '-j', type=int, default=os.cpu_count() or 1,
+                      help='Parallel codegen jobs (default: number of CPUs)')
+    
+    parser.add_argument('--codegen-jobs', type=int, default=1,
+                      help='Split the obfuscated module into N partitions and run '
+                           'codegen on them in parallel (default: 1, no splitting)')
+    
+    parser.add_argument('--lto', choices=['full', 'thin'], default='full',
+                      help='full: link all bitcode and obfuscate it as one module; '
+                           'thin: obfuscate each module in parallel and link with '
+                           'ThinLTO (default: full)')
+    
+    parser.add_argument('--techniques', type=lambda v: [t for t in v.split(',') if t],
+                        default=[], metavar='NAME[,NAME...]',
+                        help=f"Techniques to apply (default: all of {','.join(TECHNIQUES)})")
+    parser.add_argument('--string-decode', choices=STRING_DECODE_STRATEGIES, default='eager',
+                        help='When encrypted strings are decoded: eager (startup), lazy '
+                             '(per string, on first use), blob, paged or compressed '
+                             '(default: eager)')
+    parser.add_argument('--runtime-lib', metavar='PATH',
+                        help='warp_rt runtime for non-eager --string-decode '
+                             '(default: libwarp_rt.a next to --pass-lib)')
+    parser.add_argument('--shared', action='store_true',
+                        help='Build a shared object (-fPIC -shared) instead of an executable')
+    parser.add_argument('--export-list', metavar='FILE',
+                        help='Symbols (one name or glob per line) to keep exported; '
+                             'everything else is internalized, then protected and renamed')
+    parser.add_argument('--string-predecode', action='store_true',
+                        help='Decode lazily decoded strings ahead of use on a low-priority '
+                             'background thread (off at run time with WARP_RT_PREDECODE=0)')
+    parser.add_argument('--string-profile-generate', action='store_true',
+                        help='Record per-string access counts and first-access times '
+                             'into $WARP_RT_PROFILE_FILE (default: warp_rt.profile) at exit')
+    parser.add_argument('--string-profile-use', metavar='PROFILE',
+                        help='warp_rt string profile: decode hot strings at startup and '
+                             'order the blob by first access')
+    parser.add_argument('--profile-generate', action='store_true',
+                        help='Build with PGO instrumentation (-fprofile-instr-generate)')
+    parser.add_argument('--profile-use', metavar='PROFDATA',
+                        help='Optimize with an instrumentation profile (.profdata)')
+    parser.add_argument('--sample-profile', metavar='PROFILE',
+                        help='Optimize with a sample profile (e.g. from AutoFDO)')
+    parser.add_argument('--profile-remap', metavar='FILE',
+                        help='.profremap file of the build the profile was collected '
+                             'from; maps its obfuscated names back to source names')
+    parser.add_argument('--split-debug', action='store_true',
+                        help='Build with -g, then strip the binary and keep its debug '
+                             'info in <output>.debug for offline symbolization')
+    parser.add_argument('--seed', type=int, default=0,
+                      help='Seed for randomized obfuscation choices (default: 0)')
+    
+    parser.add_argument('--telemetry-dir',
+                      help='Also copy per-module pass telemetry into this directory '
+                           'for build-wide aggregation with warp_telemetry_agg.py')
+    
+    parser.add_argument('--time-trace', metavar='FILE',
+                      help='Write a Chrome trace of the obfuscation pass to FILE '
+                           '(per-module FILE.<module>.json with --lto thin)')
+    
+    parser.add_argument('--remarks-file', metavar='FILE',
+                      help='Serialize the pass optimization remarks to FILE '
+                           '(per-module FILE.<module>.<ext> with --lto thin)')
+    
+    parser.add_argument('--remarks-format', choices=['yaml', 'bitstream'], default='yaml',
+                      help='Remarks serialization format (default: yaml)')
+    
+    parser.add_argument('--size-report', action='store_true',
+                        help='Also build an unobfuscated baseline and attribute size growth '
+                             'per function, section and technique')
+    parser.add_argument('--overhead-report', action='store_true',
+                        help='Estimate the per-call runtime cost added to each function '
+                             'from the target cost model')
+    parser.add_argument('--max-overhead', type=float, metavar='LATENCY',
+                        help='Fail if any function gains more than LATENCY estimated '
+                             'cycles per call (implies --overhead-report)')
     parser.add_argument('--verbose', '-v', action='store_true',
                       help='Enable verbose output')
     
     parser.add_argument('--keep-temp', action='store_true',
                       help='Keep temporary files for debugging')
     
+    parser.add_argument('--cache-dir', default=default_cache_dir(),
+                      help='Bitcode artifact cache directory (default: ~/.cache/warp_aai)')
+    
+    parser.add_argument('--cache-max-size', type=int, default=1024,
+                      help='Cache size limit in MiB before LRU eviction (default: 1024)')
+    
+    parser.add_argument('--no-cache', action='store_true',
+                      help='Always recompile and re-obfuscate, bypassing the cache')
+    
     args = parser.parse_args()
+    unknown = set(args.techniques) - set(TECHNIQUES)
+    if unknown:
+        parser.error(f"unknown technique(s): {', '.join(sorted(unknown))}")
     
     # Create and run toolchain
     toolchain = WarpAAIToolchain()
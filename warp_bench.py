@@ -0,0 +1,236 @@
+#!/usr/bin/env python3
+"""
+warp_bench.py - Compile-time scaling benchmark for SimpleObfPass
+
+Generates synthetic modules of increasing size with warp_irgen (optionally
+mixed with llvm-stress functions), runs the pass over each, and reports how
+the time of every technique and the peak memory grow with module size.
+A fitted scaling exponent well above 1 means a technique does more than
+linear work (e.g. rescanning the module), long before a real build hits it.
+
+EDUCATIONAL MVP ONLY - part of the warp_aai educational obfuscation toolchain.
+"""
+
+import argparse
+import json
+import math
+import os
+import shutil
+import statistics
+import subprocess
+import sys
+import tempfile
+import time
+
+DIMENSIONS = ("functions", "blocks", "globals", "strings", "string-length", "llvm-stress")
+
+DEFAULT_SHAPE = {
+    "functions": 1000,
+    "blocks": 4,
+    "globals": 1000,
+    "strings": 1000,
+    "string-length": 16,
+    "llvm-stress": 0,
+}
+
+
+def parse_shape(text):
+    """'functions=1000,strings=50' -> dict over DEFAULT_SHAPE"""
+    shape = dict(DEFAULT_SHAPE)
+    for item in filter(None, text.split(',')):
+        name, _, value = item.partition('=')
+        if name not in shape:
+            raise argparse.ArgumentTypeError(f"unknown dimension '{name}'")
+        shape[name] = int(value)
+    return shape
+
+
+def find_tool(name, explicit, option):
+    """A built tool from its command-line option, a local build directory, or PATH"""
+    candidates = [explicit] if explicit else [
+        os.path.join(d, 'bin', name) for d in ('build', '_build')]
+    for path in candidates:
+        if path and os.path.exists(path):
+            return path
+    found = shutil.which(name)
+    if found:
+        return found
+    raise RuntimeError(f"{name} not found; build it or pass {option}")
+
+
+def find_irgen(explicit):
+    return find_tool('warp_irgen', explicit, '--irgen')
+
+
+def run(cmd):
+    result = subprocess.run(cmd, capture_output=True, text=True)
+    if result.returncode != 0:
+        raise RuntimeError(f"{' '.join(cmd)} failed:\n{result.stderr}")
+    return result
+
+
+def generate_module(irgen, shape, seed, work_dir):
+    """Build one synthetic module; llvm-stress functions are linked in"""
+    base = os.path.join(work_dir, "synthetic.bc")
+    run([irgen, f"-functions={shape['functions']}", f"-blocks={shape['blocks']}",
+         f"-globals={shape['globals']}", f"-strings={shape['strings']}",
+         f"-string-length={shape['string-length']}", f"-seed={seed}", "-o", base])
+    if not shape["llvm-stress"]:
+        return base
+
+    # Each seed yields one function named autogen_SD<seed>
+    stress_files = []
+    for i in range(shape["llvm-stress"]):
+        path = os.path.join(work_dir, f"stress{i}.ll")
+        run(['llvm-stress', f'-seed={seed + i}', '-size=100', '-o', path])
+        stress_files.append(path)
+    linked = os.path.join(work_dir, "linked.bc")
+    run(['llvm-link', base] + stress_files + ['-o', linked])
+    return linked
+
+
+def run_pass(pass_lib, module, cycles, work_dir):
+    """One timed opt run; returns wall seconds and the pass telemetry"""
+    telemetry = os.path.join(work_dir, "telemetry.json")
+    cmd = ['opt', '-load', pass_lib, '-enable-new-pm=0', '-simple-obf',
+           f'-obf-cycles={cycles}', f'-obf-telemetry-file={telemetry}',
+           module, '-o', os.devnull]
+    start = time.perf_counter()
+    run(cmd)
+    wall = time.perf_counter() - start
+    with open(telemetry, 'r') as f:
+        return wall, json.load(f)
+
+
+def scaling_exponent(points):
+    """Least-squares slope of log(value) over log(size); None if undefined"""
+    logs = [(math.log(x), math.log(y)) for x, y in points if x > 0 and y > 0]
+    if len(logs) < 2:
+        return None
+    mean_x = statistics.fmean(x for x, _ in logs)
+    mean_y = statistics.fmean(y for _, y in logs)
+    var = sum((x - mean_x) ** 2 for x, _ in logs)
+    if var == 0:
+        return None
+    return sum((x - mean_x) * (y - mean_y) for x, y in logs) / var
+
+
+def benchmark(args):
+    irgen = find_irgen(args.irgen)
+    points = []
+    with tempfile.TemporaryDirectory(prefix="warp_bench_") as work_dir:
+        for scale in args.scales:
+            shape = dict(args.shape, **{args.dimension: scale})
+            module = generate_module(irgen, shape, args.seed, work_dir)
+
+            runs = [run_pass(args.pass_lib, module, args.cycles, work_dir)
+                    for _ in range(args.repeat)]
+            # Median over repetitions for every timing
+            techniques = {
+                name: statistics.median(t["technique_seconds"][name] for _, t in runs)
+                for name in runs[0][1].get("technique_seconds", {})
+            }
+            point = {
+                "scale": scale,
+                "shape": shape,
+                "wall_seconds": statistics.median(wall for wall, _ in runs),
+                "pass_seconds": statistics.median(t["total_seconds"] for _, t in runs),
+                "technique_seconds": techniques,
+                "peak_rss_bytes": max(t.get("peak_rss_bytes", 0) for _, t in runs),
+                "instructions_before": runs[0][1].get("instructions_before", 0),
+                "instructions_after": runs[0][1].get("instructions_after", 0),
+                # Per-run values, for statistical comparison (warp_regress.py)
+                "samples": {
+                    "wall_seconds": [wall for wall, _ in runs],
+                    "pass_seconds": [t["total_seconds"] for _, t in runs],
+                    "peak_rss_bytes": [t.get("peak_rss_bytes", 0) for _, t in runs],
+                },
+            }
+            points.append(point)
+            if not args.quiet:
+                print(f"[INFO] {args.dimension}={scale}: pass {point['pass_seconds']:.3f}s, "
+                      f"peak RSS {point['peak_rss_bytes'] / (1 << 20):.1f} MiB")
+
+    exponents = {
+        "pass_seconds": scaling_exponent([(p["scale"], p["pass_seconds"]) for p in points]),
+        "peak_rss_bytes": scaling_exponent([(p["scale"], p["peak_rss_bytes"]) for p in points]),
+    }
+    for name in points[0]["technique_seconds"] if points else ():
+        exponents[name] = scaling_exponent(
+            [(p["scale"], p["technique_seconds"][name]) for p in points])
+
+    superlinear = sorted(name for name, k in exponents.items()
+                         if k is not None and k > args.threshold)
+    return {
+        "dimension": args.dimension,
+        "cycles": args.cycles,
+        "repeat": args.repeat,
+        "seed": args.seed,
+        "points": points,
+        "scaling_exponents": exponents,
+        "superlinear": superlinear,
+        "threshold": args.threshold,
+    }
+
+
+def print_summary(report):
+    print(f"[INFO] Scaling exponents over {report['dimension']} (1.0 = linear):")
+    for name, k in report["scaling_exponents"].items():
+        shown = "n/a" if k is None else f"{k:.2f}"
+        print(f"[INFO]   {name:<18} {shown}")
+    for name in report["superlinear"]:
+        print(f"[WARNING] {name} grows superlinearly "
+              f"(exponent {report['scaling_exponents'][name]:.2f} > {report['threshold']})")
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Measure SimpleObfPass time and memory across synthetic module sizes")
+    parser.add_argument('--pass-lib', required=True,
+                        help='Path to compiled obfuscation pass library')
+    parser.add_argument('--irgen',
+                        help='warp_irgen binary (default: build/bin, _build/bin, then PATH)')
+    parser.add_argument('--dimension', choices=DIMENSIONS, default='functions',
+                        help='Module dimension to scale (default: functions)')
+    parser.add_argument('--scales', type=lambda v: [int(s) for s in v.split(',') if s],
+                        default=[1000, 10000, 100000],
+                        help='Comma-separated sizes for the scaled dimension '
+                             '(default: 1000,10000,100000)')
+    parser.add_argument('--shape', type=parse_shape, default=dict(DEFAULT_SHAPE),
+                        help='Fixed sizes of the other dimensions, e.g. '
+                             'functions=1000,strings=500,llvm-stress=10')
+    parser.add_argument('--cycles', type=int, default=1,
+                        help='Obfuscation cycles per run (default: 1)')
+    parser.add_argument('--repeat', type=int, default=7,
+                        help='Runs per size; medians are reported (default: 7, enough '
+                             'for warp_regress.py to reach p < 0.01)')
+    parser.add_argument('--seed', type=int, default=0,
+                        help='Generator seed (default: 0)')
+    parser.add_argument('--threshold', type=float, default=1.25,
+                        help='Exponent above which growth is flagged (default: 1.25)')
+    parser.add_argument('--fail-superlinear', action='store_true',
+                        help='Exit with status 1 when anything is flagged')
+    parser.add_argument('--out', default='warp_bench.json',
+                        help='Report path (default: warp_bench.json)')
+    parser.add_argument('--quiet', '-q', action='store_true',
+                        help='Only write the report file')
+    args = parser.parse_args()
+
+    try:
+        report = benchmark(args)
+    except RuntimeError as e:
+        print(f"[ERROR] {e}", file=sys.stderr)
+        return 1
+
+    with open(args.out, 'w') as f:
+        json.dump(report, f, indent=2)
+
+    if not args.quiet:
+        print_summary(report)
+        print(f"[INFO] Benchmark report saved: {args.out}")
+
+    return 1 if args.fail_superlinear and report["superlinear"] else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,296 @@
+#!/usr/bin/env python3
+"""
+warp_difftest.py - Parallel differential testing of the obfuscation pass
+
+Builds a corpus of programs once without the pass: every workload in
+workloads/ plus --generated synthetic programs from warp_irgen -main.
+Then builds and runs every program under a matrix of pass seeds,
+technique configurations and string decode strategies, spread over
+--jobs worker threads. Each obfuscated run must reproduce the original
+program's output and exit code; any difference, build failure or timeout
+is a failure, reported with the command line that reproduces it.
+
+Configurations are technique names joined with '+' (e.g.
+"strings+rename_globals") or "all". Generated programs print timings and
+a resident set size; only their request result is compared.
+
+EDUCATIONAL MVP ONLY - part of the warp_aai educational obfuscation toolchain.
+"""
+
+import argparse
+import itertools
+import json
+import os
+import re
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+from concurrent.futures import ThreadPoolExecutor, as_completed
+from pathlib import Path
+
+from warp_aai import STRING_DECODE_STRATEGIES, TECHNIQUES, WarpAAIToolchain
+from warp_bench import find_irgen, run
+from warp_workloads import QuietToolchain, parse_workload_args
+
+# "warp_startup <entry ns> <request done ns> <result> <pages>" -> result only
+STARTUP_LINE = re.compile(rb'^warp_startup \d+ \d+ (-?\d+) \d+$', re.MULTILINE)
+
+
+def config_techniques(config):
+    """'all' -> [] (every technique), 'a+b' -> ['a', 'b']"""
+    return [] if config == "all" else config.split('+')
+
+
+def build_corpus(args, work_dir):
+    """Returns {program: bitcode}"""
+    corpus = {}
+    if args.workloads:
+        toolchain = QuietToolchain()
+        toolchain.verbose = args.verbose
+        sources = sorted(Path(args.workloads).glob('*.c'))
+        for source in sources:
+            out_dir = os.path.join(work_dir, source.stem)
+            os.makedirs(out_dir, exist_ok=True)
+            corpus[source.stem] = toolchain.compile_to_bitcode([str(source)], out_dir)[0]
+    if args.generated:
+        irgen = find_irgen(args.irgen)
+        for index in range(args.generated):
+            name = f"generated_{index}"
+            out_dir = os.path.join(work_dir, name)
+            os.makedirs(out_dir, exist_ok=True)
+            corpus[name] = os.path.join(out_dir, f"{name}.bc")
+            run([irgen, '-main', '-string-use=puts', f'-functions={args.gen_functions}',
+                 f'-request-functions={args.gen_functions}', '-blocks=3',
+                 f'-globals={args.gen_functions}', f'-strings={args.gen_functions * 2}',
+                 f'-seed={index}', '-o', corpus[name]])
+    return corpus
+
+
+def execute(binary, program_args, timeout):
+    """(exit code, normalized stdout), or (None, reason)"""
+    try:
+        result = subprocess.run([binary] + program_args, capture_output=True,
+                                timeout=timeout)
+    except subprocess.TimeoutExpired:
+        return None, f"timed out after {timeout}s"
+    return result.returncode, STARTUP_LINE.sub(rb'warp_startup \1', result.stdout)
+
+
+class Job:
+    def __init__(self, program, seed, config, string_decode):
+        self.program = program
+        self.seed = seed
+        self.config = config
+        self.string_decode = string_decode
+
+    @property
+    def label(self):
+        return f"{self.program} seed={self.seed} [{self.config}] decode={self.string_decode}"
+
+    def toolchain(self, args):
+        toolchain = QuietToolchain()
+        toolchain.verbose = args.verbose
+        toolchain.techniques = config_techniques(self.config)
+        toolchain.string_decode = self.string_decode
+        toolchain.runtime_lib = args.runtime_lib
+        return toolchain
+
+    def reproduce(self, args, bitcode):
+        """opt command line producing this configuration's module"""
+        pass_args = self.toolchain(args).pass_arguments(
+            args.xor_key, args.bogus_count, args.cycles, self.seed)
+        return ' '.join(['opt', '-load', args.pass_lib] + pass_args + [bitcode])
+
+
+def build_reference(name, bitcode, args):
+    toolchain = QuietToolchain()
+    toolchain.verbose = args.verbose
+    binary = os.path.join(os.path.dirname(bitcode), f"{name}.original")
+    toolchain.compile_to_native(bitcode, binary)
+    return execute(binary, args.program_args.get(name, []), args.timeout)
+
+
+def check(job, bitcode, reference, args):
+    """Returns a result dict; status is pass, mismatch, build_failed or timeout"""
+    result = {"program": job.program, "seed": job.seed, "config": job.config,
+              "string_decode": job.string_decode, "status": "pass"}
+    toolchain = job.toolchain(args)
+    stem = os.path.join(os.path.dirname(bitcode),
+                        f"{job.program}.s{job.seed}.{job.config}.{job.string_decode}")
+    outputs = [f"{stem}.bc", f"{stem}.json", stem]
+    try:
+        toolchain.run_obfuscation_pass(bitcode, outputs[0], args.pass_lib, args.xor_key,
+                                       args.bogus_count, args.cycles, job.seed,
+                                       telemetry_file=outputs[1])
+        toolchain.compile_to_native(outputs[0], stem)
+    except RuntimeError as e:
+        result.update(status="build_failed", detail=str(e).strip())
+        return result
+
+    code, out = execute(stem, args.program_args.get(job.program, []), args.timeout)
+    if code is None:
+        result.update(status="timeout", detail=out)
+    elif (code, out) != reference:
+        detail = []
+        if code != reference[0]:
+            detail.append(f"exit code {code}, expected {reference[0]}")
+        if out != reference[1]:
+            detail.append("output differs")
+        result.update(status="mismatch", detail="; ".join(detail))
+
+    if result["status"] == "pass" and not args.keep_builds:
+        for path in outputs:
+            if os.path.exists(path):
+                os.remove(path)
+    return result
+
+
+def run_matrix(corpus, args):
+    """Returns (results, reference failures)"""
+    references = {}
+    broken = []
+    with ThreadPoolExecutor(max_workers=args.jobs) as pool:
+        futures = {pool.submit(build_reference, name, bitcode, args): name
+                   for name, bitcode in corpus.items()}
+        for future in as_completed(futures):
+            name = futures[future]
+            try:
+                code, out = future.result()
+            except RuntimeError as e:
+                broken.append(f"{name}: original build failed: {e}")
+                continue
+            if code is None:
+                broken.append(f"{name}: original {out}")
+                continue
+            references[name] = (code, out)
+
+    jobs = [Job(program, seed, config, strategy)
+            for program, seed, config, strategy in itertools.product(
+                sorted(references), range(args.first_seed, args.first_seed + args.seeds),
+                args.configs, args.string_decode)]
+    print(f"[INFO] Running {len(jobs)} configurations of {len(references)} programs "
+          f"on {args.jobs} workers")
+
+    results = []
+    with ThreadPoolExecutor(max_workers=args.jobs) as pool:
+        futures = {pool.submit(check, job, corpus[job.program], references[job.program],
+                               args): job for job in jobs}
+        for future in as_completed(futures):
+            job = futures[future]
+            result = future.result()
+            results.append(result)
+            if result["status"] != "pass":
+                print(f"[FAIL] {job.label}: {result['status']}: "
+                      f"{result['detail'].splitlines()[0]}", file=sys.stderr)
+                print(f"       reproduce: {job.reproduce(args, corpus[job.program])}",
+                      file=sys.stderr)
+            if args.verbose or len(results) % 100 == 0:
+                print(f"[INFO] {len(results)}/{len(jobs)} done")
+    return results, broken
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Differentially test obfuscated builds against the originals")
+    parser.add_argument('--pass-lib', required=True,
+                        help='Path to compiled obfuscation pass library')
+    parser.add_argument('--runtime-lib',
+                        help='warp_rt runtime (default: libwarp_rt.a next to --pass-lib)')
+    parser.add_argument('--workloads', default=os.path.join(os.path.dirname(
+                        os.path.abspath(__file__)), 'workloads'),
+                        help='Directory of C programs to include (default: workloads/)')
+    parser.add_argument('--no-workloads', dest='workloads', action='store_const', const=None,
+                        help='Only test generated programs')
+    parser.add_argument('--generated', type=int, default=8,
+                        help='Synthetic programs from warp_irgen -main (default: 8)')
+    parser.add_argument('--gen-functions', type=int, default=20,
+                        help='Functions per generated program (default: 20)')
+    parser.add_argument('--irgen',
+                        help='warp_irgen binary (default: build/bin, _build/bin, then PATH)')
+    parser.add_argument('--seeds', type=int, default=4,
+                        help='Pass seeds per program and configuration (default: 4)')
+    parser.add_argument('--first-seed', type=int, default=0,
+                        help='First pass seed (default: 0)')
+    parser.add_argument('--configs', type=lambda v: [c for c in v.split(',') if c],
+                        default=list(TECHNIQUES) + ["all"],
+                        help='Comma-separated configurations: technique names joined '
+                             'with "+", or "all" (default: each technique, then all)')
+    parser.add_argument('--string-decode', type=lambda v: [s for s in v.split(',') if s],
+                        default=["eager"],
+                        help='Comma-separated string decode strategies (default: eager)')
+    parser.add_argument('--args', dest='program_args', action='append', default=[],
+                        metavar='NAME=ARGS', help='Arguments for one program, e.g. fib=25')
+    parser.add_argument('--xor-key', type=int, default=170)
+    parser.add_argument('--bogus-count', type=int, default=2)
+    parser.add_argument('--cycles', type=int, default=1)
+    parser.add_argument('--jobs', '-j', type=int, default=os.cpu_count() or 1,
+                        help='Parallel builds and runs (default: one per CPU)')
+    parser.add_argument('--timeout', type=float, default=60,
+                        help='Seconds before a run counts as hung (default: 60)')
+    parser.add_argument('--out', help='Write a JSON report here')
+    parser.add_argument('--keep-builds', metavar='DIR',
+                        help='Build into DIR and keep every binary (failing ones '
+                             'are always kept there)')
+    parser.add_argument('--verbose', '-v', action='store_true')
+    args = parser.parse_args()
+    args.program_args = parse_workload_args(args.program_args)
+    args.pass_lib = os.path.abspath(args.pass_lib)
+    args.runtime_lib = args.runtime_lib or WarpAAIToolchain.default_runtime_lib(args.pass_lib)
+
+    for config in args.configs:
+        unknown = set(config_techniques(config)) - set(TECHNIQUES)
+        if unknown:
+            parser.error(f"unknown technique(s) in '{config}': {', '.join(sorted(unknown))}")
+    unknown = set(args.string_decode) - set(STRING_DECODE_STRATEGIES)
+    if unknown:
+        parser.error(f"unknown strategy(ies): {', '.join(sorted(unknown))}")
+    if args.string_decode != ["eager"] and not os.path.exists(args.runtime_lib):
+        parser.error(f"warp_rt runtime not found: {args.runtime_lib}")
+
+    start = time.time()
+    build_dir = args.keep_builds or tempfile.mkdtemp(prefix="warp_difftest_")
+    results, broken = [], []
+    try:
+        corpus = build_corpus(args, build_dir)
+        if not corpus:
+            print("[ERROR] Empty corpus", file=sys.stderr)
+            return 1
+        results, broken = run_matrix(corpus, args)
+    except RuntimeError as e:
+        print(f"[ERROR] {e}", file=sys.stderr)
+        return 1
+    finally:
+        # Passing builds are already gone; keep the failing ones to debug
+        if args.keep_builds:
+            pass
+        elif broken or any(r["status"] != "pass" for r in results):
+            print(f"[INFO] Failing builds kept in {build_dir}")
+        else:
+            shutil.rmtree(build_dir, ignore_errors=True)
+
+    failures = [r for r in results if r["status"] != "pass"]
+    if args.out:
+        with open(args.out, 'w') as f:
+            json.dump({
+                "parameters": {
+                    "programs": sorted(corpus), "seeds": args.seeds,
+                    "first_seed": args.first_seed, "configs": args.configs,
+                    "string_decode": args.string_decode, "xor_key": args.xor_key,
+                    "bogus_count": args.bogus_count, "cycles": args.cycles,
+                },
+                "total": len(results),
+                "failures": failures,
+                "broken_programs": broken,
+            }, f, indent=2)
+
+    for message in broken:
+        print(f"[ERROR] {message}", file=sys.stderr)
+    print(f"[INFO] {len(results) - len(failures)}/{len(results)} configurations match "
+          f"the original ({time.time() - start:.1f}s)")
+    return 1 if failures or broken else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,261 @@
+/*
+ * warp_irgen.cpp - Synthetic IR module generator for warp_aai benchmarks
+ *
+ * EDUCATIONAL MVP ONLY - part of the warp_aai educational obfuscation toolchain.
+ *
+ * Produces a module with a configurable number of functions, basic blocks per
+ * function, private globals and private string constants of a given length,
+ * so SimpleObfPass can be measured on inputs far larger than example.c.
+ * Output is fully determined by the options and -seed.
+ *
+ * Every function has the shape
+ *
+ *   i32 @synth_N(i32 %x):
+ *     entry: slot = x + globals...; br bb0
+ *     bbK:   slot = slot op C; br (slot < limit), bbK+1, exit
+ *     exit:  puts(strings...); ret slot
+ *
+ * Global and string I belong to function I % functions, so every entity is
+ * referenced and survives llvm-link, which drops unused private globals.
+ *
+ * With -main the module is a complete program for startup measurements
+ * (warp_startup_bench.py): main reads CLOCK_MONOTONIC on entry, serves a
+ * "first request" by calling synth_0 .. synth_{R-1}, reads the clock again
+ * and prints "warp_startup <entry ns> <request done ns> <result> <pages>",
+ * where pages is the resident set from /proc/self/statm (0 if unreadable).
+ */
+
+#include "llvm/Bitcode/BitcodeWriter.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/GlobalVariable.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IR/Verifier.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/InitLLVM.h"
+#include "llvm/Support/ToolOutputFile.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace llvm;
+
+static cl::opt<std::string> OutputFilename("o",
+    cl::desc("Output file (default: stdout)"),
+    cl::value_desc("filename"), cl::init("-"));
+
+static cl::opt<bool> OutputAssembly("S",
+    cl::desc("Write textual IR instead of bitcode"));
+
+static cl::opt<unsigned> NumFunctions("functions",
+    cl::desc("Number of functions"), cl::init(100));
+
+static cl::opt<unsigned> NumBlocks("blocks",
+    cl::desc("Basic blocks per function, besides entry and exit"), cl::init(4));
+
+static cl::opt<unsigned> NumGlobals("globals",
+    cl::desc("Number of private i32 globals"), cl::init(100));
+
+static cl::opt<unsigned> NumStrings("strings",
+    cl::desc("Number of private string constants"), cl::init(100));
+
+static cl::opt<unsigned> StringLength("string-length",
+    cl::desc("Length of each string, excluding the terminator"), cl::init(16));
+
+enum StringUse { UsePuts, UseStrlen };
+
+static cl::opt<StringUse> StringUseKind("string-use",
+    cl::desc("How exit blocks use their strings"),
+    cl::init(UsePuts),
+    cl::values(
+        clEnumValN(UsePuts, "puts", "Print each string"),
+        clEnumValN(UseStrlen, "strlen", "Add each string's length to the result")));
+
+static cl::opt<bool> EmitMain("main",
+    cl::desc("Add a main that times a first request to the synth functions"));
+
+static cl::opt<unsigned> RequestFunctions("request-functions",
+    cl::desc("Functions the first request of -main calls"), cl::init(1));
+
+static cl::opt<unsigned long long> Seed("seed",
+    cl::desc("Seed for constants and string contents"), cl::init(0));
+
+static cl::opt<bool> Verify("verify",
+    cl::desc("Run the IR verifier before writing"), cl::init(true));
+
+static std::string randomString(std::mt19937_64 &Rng, unsigned Length) {
+    static const char Alphabet[] =
+        "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789 .,:-_";
+    std::string S(Length, ' ');
+    for (char &C : S)
+        C = Alphabet[Rng() % (sizeof(Alphabet) - 1)];
+    return S;
+}
+
+static void buildFunction(Module &M, unsigned Index, std::mt19937_64 &Rng,
+                          ArrayRef<GlobalVariable *> Globals,
+                          ArrayRef<GlobalVariable *> Strings, FunctionCallee Use) {
+    LLVMContext &Ctx = M.getContext();
+    Type *I32 = Type::getInt32Ty(Ctx);
+    FunctionType *FT = FunctionType::get(I32, I32, false);
+    Function *F = Function::Create(FT, GlobalValue::ExternalLinkage,
+                                   "synth_" + Twine(Index), M);
+
+    BasicBlock *Entry = BasicBlock::Create(Ctx, "entry", F);
+    BasicBlock *Exit = BasicBlock::Create(Ctx, "exit", F);
+    std::vector<BasicBlock *> Body;
+    for (unsigned K = 0; K < NumBlocks; ++K)
+        Body.push_back(BasicBlock::Create(Ctx, "bb" + Twine(K), F, Exit));
+
+    IRBuilder<> B(Entry);
+    AllocaInst *Slot = B.CreateAlloca(I32, nullptr, "slot");
+    Value *Init = F->getArg(0);
+    for (size_t G = Index; G < Globals.size(); G += NumFunctions)
+        Init = B.CreateAdd(Init, B.CreateLoad(I32, Globals[G]));
+    B.CreateStore(Init, Slot);
+    B.CreateBr(Body.empty() ? Exit : Body.front());
+
+    static const Instruction::BinaryOps Ops[] = {
+        Instruction::Add, Instruction::Mul, Instruction::Xor, Instruction::Sub};
+    for (unsigned K = 0; K < Body.size(); ++K) {
+        B.SetInsertPoint(Body[K]);
+        Value *V = B.CreateLoad(I32, Slot);
+        V = B.CreateBinOp(Ops[Rng() % 4], V, ConstantInt::get(I32, Rng() % 1000 + 1));
+        B.CreateStore(V, Slot);
+        if (K + 1 == Body.size()) {
+            B.CreateBr(Exit);
+        } else {
+            Value *Cond = B.CreateICmpSLT(V, ConstantInt::get(I32, Rng() % 100000));
+            B.CreateCondBr(Cond, Body[K + 1], Exit);
+        }
+    }
+
+    B.SetInsertPoint(Exit);
+    Value *Result = B.CreateLoad(I32, Slot);
+    for (size_t I = Index; I < Strings.size(); I += NumFunctions) {
+        GlobalVariable *S = Strings[I];
+        Value *Len = B.CreateCall(Use, B.CreateConstInBoundsGEP2_64(S->getValueType(), S, 0, 0));
+        if (StringUseKind == UseStrlen)
+            Result = B.CreateAdd(Result, B.CreateTrunc(Len, I32));
+    }
+    B.CreateRet(Result);
+}
+
+// i64 now(): CLOCK_MONOTONIC in nanoseconds (struct timespec as { i64, i64 })
+static Value *readClock(IRBuilder<> &B, FunctionCallee ClockGettime, Value *Spec) {
+    Type *I64 = B.getInt64Ty();
+    StructType *SpecTy = StructType::get(I64, I64);
+    B.CreateCall(ClockGettime, {B.getInt32(1), Spec});
+    Value *Sec = B.CreateLoad(I64, B.CreateStructGEP(SpecTy, Spec, 0));
+    Value *Nsec = B.CreateLoad(I64, B.CreateStructGEP(SpecTy, Spec, 1));
+    return B.CreateAdd(B.CreateMul(Sec, B.getInt64(1000000000)), Nsec);
+}
+
+static void buildMain(Module &M) {
+    LLVMContext &Ctx = M.getContext();
+    Type *I32 = Type::getInt32Ty(Ctx);
+    Type *I8Ptr = Type::getInt8PtrTy(Ctx);
+    StructType *SpecTy = StructType::get(Type::getInt64Ty(Ctx), Type::getInt64Ty(Ctx));
+    FunctionCallee ClockGettime = M.getOrInsertFunction(
+        "clock_gettime", I32, I32, SpecTy->getPointerTo());
+    FunctionCallee Printf = M.getOrInsertFunction(
+        "printf", FunctionType::get(I32, I8Ptr, true));
+    Function *Main = Function::Create(
+        FunctionType::get(I32, {I32, I8Ptr->getPointerTo()}, false),
+        GlobalValue::ExternalLinkage, "main", M);
+
+    IRBuilder<> B(BasicBlock::Create(Ctx, "entry", Main));
+    Value *Spec = B.CreateAlloca(SpecTy, nullptr, "ts");
+    Value *Start = readClock(B, ClockGettime, Spec);
+    Value *Result = B.getInt32(0);
+    for (unsigned I = 0; I < std::min(RequestFunctions.getValue(), NumFunctions.getValue()); ++I)
+        Result = B.CreateAdd(Result, B.CreateCall(M.getFunction(("synth_" + Twine(I)).str()),
+                                                  Main->getArg(0)));
+    Value *Done = readClock(B, ClockGettime, Spec);
+
+    // Resident pages after the request: a fresh per-process figure, unlike
+    // ru_maxrss, which keeps the forking parent's high-water mark
+    Type *I64 = B.getInt64Ty();
+    FunctionCallee Fopen = M.getOrInsertFunction("fopen", I8Ptr, I8Ptr, I8Ptr);
+    FunctionCallee Fscanf = M.getOrInsertFunction(
+        "fscanf", FunctionType::get(I32, {I8Ptr, I8Ptr}, true));
+    FunctionCallee Fclose = M.getOrInsertFunction("fclose", I32, I8Ptr);
+    Value *Size = B.CreateAlloca(I64, nullptr, "size");
+    Value *Resident = B.CreateAlloca(I64, nullptr, "resident");
+    B.CreateStore(B.getInt64(0), Resident);
+    Value *Statm = B.CreateCall(Fopen, {B.CreateGlobalStringPtr("/proc/self/statm"),
+                                        B.CreateGlobalStringPtr("r")});
+    BasicBlock *Read = BasicBlock::Create(Ctx, "read_statm", Main);
+    BasicBlock *Report = BasicBlock::Create(Ctx, "report", Main);
+    B.CreateCondBr(B.CreateIsNull(Statm), Report, Read);
+    B.SetInsertPoint(Read);
+    B.CreateCall(Fscanf, {Statm, B.CreateGlobalStringPtr("%lld %lld"), Size, Resident});
+    B.CreateCall(Fclose, Statm);
+    B.CreateBr(Report);
+
+    B.SetInsertPoint(Report);
+    B.CreateCall(Printf, {B.CreateGlobalStringPtr("warp_startup %lld %lld %d %lld\n"),
+                          Start, Done, Result, B.CreateLoad(I64, Resident)});
+    B.CreateRet(B.getInt32(0));
+}
+
+int main(int argc, char **argv) {
+    InitLLVM X(argc, argv);
+    cl::ParseCommandLineOptions(argc, argv, "warp_aai synthetic IR module generator\n");
+
+    LLVMContext Ctx;
+    Module M("warp_synthetic", Ctx);
+    M.setSourceFileName("warp_synthetic_" + std::to_string(Seed) + ".c");
+    std::mt19937_64 Rng(Seed);
+    Type *I32 = Type::getInt32Ty(Ctx);
+
+    std::vector<GlobalVariable *> Globals;
+    Globals.reserve(NumGlobals);
+    for (unsigned I = 0; I < NumGlobals; ++I) {
+        Globals.push_back(new GlobalVariable(
+            M, I32, false, GlobalValue::PrivateLinkage,
+            ConstantInt::get(I32, Rng() % 1000), "g." + Twine(I)));
+    }
+
+    std::vector<GlobalVariable *> Strings;
+    Strings.reserve(NumStrings);
+    for (unsigned I = 0; I < NumStrings; ++I) {
+        Constant *Data = ConstantDataArray::getString(Ctx, randomString(Rng, StringLength));
+        auto *S = new GlobalVariable(M, Data->getType(), true, GlobalValue::PrivateLinkage,
+                                     Data, ".str." + Twine(I));
+        S->setUnnamedAddr(GlobalValue::UnnamedAddr::Global);
+        Strings.push_back(S);
+    }
+
+    FunctionCallee Use = StringUseKind == UseStrlen
+        ? M.getOrInsertFunction("strlen", Type::getInt64Ty(Ctx), Type::getInt8PtrTy(Ctx))
+        : M.getOrInsertFunction("puts", I32, Type::getInt8PtrTy(Ctx));
+    for (unsigned I = 0; I < NumFunctions; ++I)
+        buildFunction(M, I, Rng, Globals, Strings, Use);
+    if (EmitMain)
+        buildMain(M);
+
+    if (Verify && verifyModule(M, &errs())) {
+        errs() << argv[0] << ": generated module is broken\n";
+        return 1;
+    }
+
+    std::error_code EC;
+    ToolOutputFile Out(OutputFilename, EC,
+                       OutputAssembly ? sys::fs::OF_Text : sys::fs::OF_None);
+    if (EC) {
+        errs() << argv[0] << ": " << OutputFilename << ": " << EC.message() << "\n";
+        return 1;
+    }
+    if (OutputAssembly)
+        M.print(Out.os(), nullptr);
+    else
+        WriteBitcodeToFile(M, Out.os());
+    Out.keep();
+    return 0;
+}
@@ -0,0 +1,356 @@
+/*
+ * warp_perf.cpp - Hardware counter comparison of obfuscated and baseline builds
+ *
+ * EDUCATIONAL MVP ONLY - part of the warp_aai educational obfuscation toolchain.
+ *
+ * Runs each build of a program with perf_event_open counters attached
+ * (no perf tool needed) and reports, per configuration, the median of
+ * every counter over -repeat runs and its delta against the baseline:
+ *
+ *   warp_perf -repeat 5 -args "35" baseline=./fib.baseline strings=./fib.strings ...
+ *
+ * Counters: instructions, cycles, branches, branch misses, L1i misses,
+ * iTLB misses, page faults and task clock; IPC and the branch miss rate
+ * are derived. Only user-space events are counted, which works with the
+ * default perf_event_paranoid setting. A counter the CPU or hypervisor
+ * does not expose is reported as unavailable rather than failing the run.
+ * Runs of the configurations are interleaved so drift affects all alike.
+ *
+ * Linux only.
+ */
+
+#include "llvm/ADT/Optional.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/InitLLVM.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <linux/perf_event.h>
+#include <sched.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace llvm;
+
+static cl::list<std::string> Configs(cl::Positional, cl::OneOrMore,
+    cl::desc("<name=binary>..."));
+
+static cl::opt<std::string> ProgramArgs("args",
+    cl::desc("Arguments passed to every binary (split on spaces)"), cl::init(""));
+
+static cl::opt<std::string> Baseline("baseline",
+    cl::desc("Configuration the deltas are relative to"), cl::init("baseline"));
+
+static cl::opt<unsigned> Repeat("repeat",
+    cl::desc("Runs per configuration; medians are reported"), cl::init(5));
+
+static cl::opt<int> Cpu("cpu",
+    cl::desc("Pin every run to this CPU (default: no pinning)"), cl::init(-1));
+
+static cl::opt<std::string> OutputFilename("o",
+    cl::desc("Write the JSON report to this file"), cl::value_desc("filename"), cl::init(""));
+
+static cl::opt<bool> Quiet("q", cl::desc("Do not print the table"));
+
+namespace {
+
+struct CounterSpec {
+    const char *name;
+    uint32_t type;
+    uint64_t config;
+};
+
+constexpr uint64_t cacheMiss(uint64_t Cache) {
+    return Cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+}
+
+const CounterSpec Counters[] = {
+    {"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {"branches", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_INSTRUCTIONS},
+    {"branch_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    {"l1i_misses", PERF_TYPE_HW_CACHE, cacheMiss(PERF_COUNT_HW_CACHE_L1I)},
+    {"itlb_misses", PERF_TYPE_HW_CACHE, cacheMiss(PERF_COUNT_HW_CACHE_ITLB)},
+    {"page_faults", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS},
+    {"task_clock_ns", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK},
+};
+constexpr size_t NumCounters = sizeof(Counters) / sizeof(Counters[0]);
+
+struct Config {
+    std::string name;
+    std::string binary;
+    // Per counter, one scaled value per run in which it was counted
+    std::vector<double> samples[NumCounters];
+    int failedExit = 0;
+};
+
+// Why each counter could not be opened, if it could not
+std::string Unavailable[NumCounters];
+
+const char *openError(int Err) {
+    switch (Err) {
+    case ENOENT:
+    case EOPNOTSUPP:
+        return "not supported by this CPU or hypervisor";
+    case EACCES:
+    case EPERM:
+        return "permission denied (see /proc/sys/kernel/perf_event_paranoid)";
+    default:
+        return strerror(Err);
+    }
+}
+
+int openCounter(const CounterSpec &Spec, pid_t Pid) {
+    perf_event_attr Attr;
+    memset(&Attr, 0, sizeof(Attr));
+    Attr.size = sizeof(Attr);
+    Attr.type = Spec.type;
+    Attr.config = Spec.config;
+    Attr.disabled = 1;
+    Attr.enable_on_exec = 1;
+    Attr.inherit = 1;
+    Attr.exclude_kernel = 1;
+    Attr.exclude_hv = 1;
+    Attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return (int)syscall(__NR_perf_event_open, &Attr, Pid, -1, -1, PERF_FLAG_FD_CLOEXEC);
+}
+
+/**
+ * One counted run: the child blocks on a pipe until every counter is
+ * attached, then execs; enable_on_exec starts counting at the exec.
+ * Returns the exit status, or -1 if the program could not be started.
+ */
+int runOnce(Config &C, ArrayRef<std::string> Args) {
+    int Go[2];
+    if (pipe(Go) != 0) return -1;
+
+    pid_t Pid = fork();
+    if (Pid < 0) return -1;
+    if (Pid == 0) {
+        close(Go[1]);
+        if (Cpu >= 0) {
+            cpu_set_t Set;
+            CPU_ZERO(&Set);
+            CPU_SET(Cpu, &Set);
+            sched_setaffinity(0, sizeof(Set), &Set);
+        }
+        int Null = open("/dev/null", O_WRONLY);
+        if (Null >= 0) dup2(Null, STDOUT_FILENO);
+        char Byte;
+        if (read(Go[0], &Byte, 1) != 1) _exit(127);
+        std::vector<char *> Argv{const_cast<char *>(C.binary.c_str())};
+        for (const std::string &A : Args) Argv.push_back(const_cast<char *>(A.c_str()));
+        Argv.push_back(nullptr);
+        execv(C.binary.c_str(), Argv.data());
+        _exit(127);
+    }
+
+    close(Go[0]);
+    int Fds[NumCounters];
+    for (size_t I = 0; I < NumCounters; ++I) {
+        Fds[I] = openCounter(Counters[I], Pid);
+        if (Fds[I] < 0 && Unavailable[I].empty())
+            Unavailable[I] = openError(errno);
+    }
+    (void)!write(Go[1], "x", 1);
+    close(Go[1]);
+
+    int Status = 0;
+    waitpid(Pid, &Status, 0);
+    for (size_t I = 0; I < NumCounters; ++I) {
+        if (Fds[I] < 0) continue;
+        uint64_t Values[3] = {0, 0, 0}; // value, time enabled, time running
+        if (read(Fds[I], Values, sizeof(Values)) == (ssize_t)sizeof(Values) && Values[2]) {
+            // Scale up when the counter was multiplexed
+            C.samples[I].push_back((double)Values[0] * Values[1] / Values[2]);
+        } else if (Unavailable[I].empty()) {
+            Unavailable[I] = "not counted (no hardware slot)";
+        }
+        close(Fds[I]);
+    }
+    return WIFEXITED(Status) ? WEXITSTATUS(Status) : 128 + WTERMSIG(Status);
+}
+
+Optional<double> median(std::vector<double> V) {
+    if (V.empty()) return None;
+    std::sort(V.begin(), V.end());
+    size_t N = V.size();
+    return N % 2 ? V[N / 2] : (V[N / 2 - 1] + V[N / 2]) / 2;
+}
+
+struct Summary {
+    Optional<double> counters[NumCounters];
+    Optional<double> ipc;
+    Optional<double> branchMissRate;
+};
+
+size_t counterIndex(StringRef Name) {
+    for (size_t I = 0; I < NumCounters; ++I)
+        if (Name == Counters[I].name) return I;
+    llvm_unreachable("unknown counter");
+}
+
+Summary summarize(const Config &C) {
+    Summary S;
+    for (size_t I = 0; I < NumCounters; ++I)
+        S.counters[I] = median(C.samples[I]);
+    auto Instructions = S.counters[counterIndex("instructions")];
+    auto Cycles = S.counters[counterIndex("cycles")];
+    auto Branches = S.counters[counterIndex("branches")];
+    auto Misses = S.counters[counterIndex("branch_misses")];
+    if (Instructions && Cycles && *Cycles > 0) S.ipc = *Instructions / *Cycles;
+    if (Branches && Misses && *Branches > 0) S.branchMissRate = *Misses / *Branches;
+    return S;
+}
+
+void printTable(ArrayRef<Config> All, ArrayRef<Summary> Sums, const Summary *Base) {
+    raw_ostream &OS = outs();
+    OS << left_justify("counter", 18);
+    for (const Config &C : All) OS << " " << right_justify(C.name, 22);
+    OS << "\n";
+
+    auto Row = [&](StringRef Label, function_ref<Optional<double>(const Summary &)> Get,
+                   bool Ratio) {
+        OS << left_justify(Label, 18);
+        for (const Summary &S : Sums) {
+            Optional<double> V = Get(S);
+            Optional<double> B = Base ? Get(*Base) : None;
+            std::string Cell = "n/a";
+            if (V) {
+                raw_string_ostream CS(Cell = "");
+                CS << format(Ratio ? "%.4f" : "%.0f", *V);
+                if (B && *B != 0 && &S != Base)
+                    CS << format(" (%+.1f%%)", (*V / *B - 1) * 100);
+            }
+            OS << " " << right_justify(Cell, 22);
+        }
+        OS << "\n";
+    };
+    for (size_t I = 0; I < NumCounters; ++I)
+        Row(Counters[I].name, [I](const Summary &S) { return S.counters[I]; }, false);
+    Row("ipc", [](const Summary &S) { return S.ipc; }, true);
+    Row("branch_miss_rate", [](const Summary &S) { return S.branchMissRate; }, true);
+    for (size_t I = 0; I < NumCounters; ++I)
+        if (!Unavailable[I].empty())
+            OS << "[WARNING] " << Counters[I].name << " unavailable: " << Unavailable[I] << "\n";
+}
+
+void writeReport(raw_ostream &OS, ArrayRef<Config> All, ArrayRef<Summary> Sums,
+                 const Summary *Base, ArrayRef<std::string> Args) {
+    json::OStream J(OS, 2);
+    auto Value = [&](StringRef Key, Optional<double> V) {
+        if (V) J.attribute(Key, *V);
+        else J.attribute(Key, nullptr);
+    };
+    J.object([&] {
+        J.attribute("repeat", (int64_t)Repeat);
+        J.attribute("cpu", (int64_t)Cpu);
+        J.attributeArray("args", [&] {
+            for (const std::string &A : Args) J.value(A);
+        });
+        J.attribute("baseline", Baseline);
+        J.attributeObject("unavailable", [&] {
+            for (size_t I = 0; I < NumCounters; ++I)
+                if (!Unavailable[I].empty()) J.attribute(Counters[I].name, Unavailable[I]);
+        });
+        J.attributeObject("configs", [&] {
+            for (size_t C = 0; C < All.size(); ++C) {
+                const Summary &S = Sums[C];
+                J.attributeObject(All[C].name, [&] {
+                    J.attribute("binary", All[C].binary);
+                    J.attribute("failed_runs", (int64_t)All[C].failedExit);
+                    J.attributeObject("counters", [&] {
+                        for (size_t I = 0; I < NumCounters; ++I)
+                            Value(Counters[I].name, S.counters[I]);
+                        Value("ipc", S.ipc);
+                        Value("branch_miss_rate", S.branchMissRate);
+                    });
+                    if (!Base || &S == Base) return;
+                    J.attributeObject("delta", [&] {
+                        for (size_t I = 0; I < NumCounters; ++I) {
+                            Optional<double> D;
+                            if (S.counters[I] && Base->counters[I])
+                                D = *S.counters[I] - *Base->counters[I];
+                            Value(Counters[I].name, D);
+                        }
+                        Value("ipc", S.ipc && Base->ipc ? Optional<double>(*S.ipc - *Base->ipc) : None);
+                    });
+                });
+            }
+        });
+    });
+    OS << "\n";
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    InitLLVM X(argc, argv);
+    cl::ParseCommandLineOptions(argc, argv,
+        "warp_aai hardware counter comparison of obfuscated builds\n");
+
+    std::vector<Config> All;
+    for (const std::string &Spec : Configs) {
+        StringRef Name, Binary;
+        std::tie(Name, Binary) = StringRef(Spec).split('=');
+        if (Name.empty() || Binary.empty()) {
+            errs() << argv[0] << ": expected name=binary, got '" << Spec << "'\n";
+            return 1;
+        }
+        if (!sys::fs::can_execute(Binary)) {
+            errs() << argv[0] << ": " << Binary << ": not executable\n";
+            return 1;
+        }
+        All.push_back(Config{Name.str(), Binary.str(), {}, 0});
+    }
+
+    SmallVector<StringRef, 8> Split;
+    StringRef(ProgramArgs).split(Split, ' ', -1, false);
+    std::vector<std::string> Args(Split.begin(), Split.end());
+
+    for (unsigned R = 0; R < Repeat; ++R) {
+        for (Config &C : All) {
+            int Code = runOnce(C, Args);
+            if (Code != 0) {
+                // Keep the counts; a workload may exit non-zero by design,
+                // but say so
+                ++C.failedExit;
+                if (Code < 0) {
+                    errs() << argv[0] << ": could not start " << C.binary << "\n";
+                    return 1;
+                }
+            }
+        }
+    }
+
+    std::vector<Summary> Sums;
+    const Summary *Base = nullptr;
+    for (const Config &C : All)
+        Sums.push_back(summarize(C));
+    for (size_t C = 0; C < All.size(); ++C)
+        if (All[C].name == Baseline) Base = &Sums[C];
+
+    if (!Quiet) printTable(All, Sums, Base);
+    if (!OutputFilename.empty()) {
+        std::error_code EC;
+        raw_fd_ostream Out(OutputFilename, EC, sys::fs::OF_Text);
+        if (EC) {
+            errs() << argv[0] << ": " << OutputFilename << ": " << EC.message() << "\n";
+            return 1;
+        }
+        writeReport(Out, All, Sums, Base, Args);
+    }
+    return 0;
+}
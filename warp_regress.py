@@ -0,0 +1,408 @@
+#!/usr/bin/env python3
+"""
+warp_regress.py - Performance baselines and regression checks
+
+Reads the JSON reports of the benchmark harnesses and flattens them into
+named metrics, each with its per-run samples:
+
+- compile/...   warp_bench.py         pass and wall seconds, peak RSS
+- runtime/...   warp_workloads.py     run seconds per workload and config,
+                                      plus warp_perf counters with --perf
+- startup/...   warp_startup_bench.py exec->main, main->request, faults, RSS
+- size/...      warp_size_report.py or a warp_aai.py --size-report report
+- sqlite/...    warp_sqlite_bench.py  pass time, peak RSS, binary size,
+                                      speedtest1 total and per-test seconds
+
+`record` stores them as a baseline, baselines/<name>.json by default,
+meant to be committed next to the code it measures. `compare` checks a new
+run against it and exits with status 1 if any metric regressed: its
+median grew by more than --threshold and the difference is significant
+(two-sided Mann-Whitney U test below --alpha, or with --method bootstrap,
+a confidence interval of the median ratio entirely above 1). Metrics with
+one sample, such as sizes, are deterministic and only need to exceed the
+threshold. So do metrics with too few samples for the U test to ever reach
+--alpha (3 against 3 cannot go below p=0.1); compare warns about them.
+Every metric is lower-is-better.
+
+Baselines hold timings, so record and compare on the same machine.
+
+EDUCATIONAL MVP ONLY - part of the warp_aai educational obfuscation toolchain.
+"""
+
+import argparse
+import fnmatch
+import json
+import math
+import os
+import platform
+import random
+import statistics
+import subprocess
+import sys
+import time
+
+SCHEMA_VERSION = 1
+DEFAULT_STORE = os.path.join(os.path.dirname(os.path.abspath(__file__)), 'baselines')
+STARTUP_METRICS = ("exec_to_main_ns", "main_to_request_ns", "exec_to_request_ns",
+                   "minor_faults", "major_faults", "rss_bytes")
+# Higher is better for these warp_perf values, so they are not compared
+DERIVED_COUNTERS = ("ipc",)
+
+
+def compile_metrics(report):
+    metrics = {}
+    for point in report["points"]:
+        prefix = f"compile/{report['dimension']}={point['scale']}"
+        samples = point.get("samples", {})
+        for name in ("pass_seconds", "wall_seconds", "peak_rss_bytes"):
+            metrics[f"{prefix}/{name}"] = samples.get(name, [point[name]])
+        metrics[f"{prefix}/instructions_after"] = [point["instructions_after"]]
+    return metrics
+
+
+def runtime_metrics(report):
+    metrics = {}
+    for workload, configs in report.get("samples", {}).items():
+        for config, seconds in configs.items():
+            metrics[f"runtime/{workload}/{config}/seconds"] = seconds
+    if not metrics:
+        # Reports without samples only have medians
+        for workload, row in report["workloads"].items():
+            metrics[f"runtime/{workload}/baseline/seconds"] = [row["baseline_median_seconds"]]
+            for config, entry in row.items():
+                if isinstance(entry, dict):
+                    metrics[f"runtime/{workload}/{config}/seconds"] = [entry["median_seconds"]]
+    for workload, configs in report.get("counters", {}).get("workloads", {}).items():
+        for config, counters in configs.items():
+            for counter, value in counters.items():
+                if counter in DERIVED_COUNTERS:
+                    continue
+                if isinstance(value, dict):
+                    value = value["value"]
+                if value is not None:
+                    metrics[f"runtime/{workload}/{config}/{counter}"] = [value]
+    return metrics
+
+
+def startup_metrics(report):
+    metrics = {}
+    for entry in report["results"]:
+        if entry.get("failed"):
+            continue
+        prefix = f"startup/N={entry['strings']},S={entry['string_length']}/{entry['strategy']}"
+        for name in STARTUP_METRICS:
+            metrics[f"{prefix}/{name}"] = entry.get("samples", {}).get(
+                name, [entry[name]["median"]])
+    return metrics
+
+
+def size_metrics(report):
+    metrics = {"size/section_delta": [report["totals"]["section_delta"]]}
+    for name, entry in report["sections"].items():
+        metrics[f"size/{name}"] = [entry["obfuscated_size"]]
+    return metrics
+
+
+def sqlite_metrics(report):
+    metrics = {}
+    for config, built in report["builds"].items():
+        for name in ("obfuscation_seconds", "peak_rss_bytes", "binary_bytes",
+                     "instructions_after"):
+            if built.get(name) is not None:
+                metrics[f"sqlite/build/{config}/{name}"] = [built[name]]
+    for config, runs in report["samples"].items():
+        metrics[f"sqlite/speedtest/{config}/total_seconds"] = runs["total"]
+        for test, seconds in runs["tests"].items():
+            metrics[f"sqlite/speedtest/{config}/{test}"] = seconds
+    return metrics
+
+
+def extract_metrics(report):
+    """{metric: [samples]} from any supported report"""
+    if "scaling_exponents" in report:
+        return compile_metrics(report)
+    if "speedtest" in report:
+        return sqlite_metrics(report)
+    if "workloads" in report and "configs" in report:
+        return runtime_metrics(report)
+    if "results" in report and "parameters" in report:
+        return startup_metrics(report)
+    if "totals" in report and "sections" in report:
+        return size_metrics(report)
+    if "size_impact" in report:
+        return size_metrics(report["size_impact"])
+    raise ValueError("not a warp_bench, warp_workloads, warp_startup_bench, "
+                     "warp_sqlite_bench or size report")
+
+
+def load_metrics(paths):
+    metrics = {}
+    for path in paths:
+        with open(path) as f:
+            try:
+                found = extract_metrics(json.load(f))
+            except (ValueError, KeyError) as e:
+                raise ValueError(f"{path}: {e}")
+        metrics.update(found)
+    return metrics
+
+
+def thin(samples, limit):
+    """At most `limit` samples with the same distribution (evenly spaced
+    order statistics), so stored baselines stay small"""
+    if len(samples) <= limit:
+        return list(samples)
+    ordered = sorted(samples)
+    return [ordered[int((i + 0.5) * len(ordered) / limit)] for i in range(limit)]
+
+
+def git_commit():
+    try:
+        result = subprocess.run(['git', 'rev-parse', 'HEAD'], capture_output=True, text=True,
+                                cwd=os.path.dirname(os.path.abspath(__file__)))
+    except OSError:
+        return None
+    return result.stdout.strip() if result.returncode == 0 else None
+
+
+# Largest n1 + n2 for which mann_whitney enumerates the exact distribution
+EXACT_LIMIT = 40
+
+
+def exact_rank_sum_p(ranks, n1, observed):
+    """Two-sided p-value of a rank sum: the share of all n1-subsets of ranks
+    whose sum lies at least as far from the mean as observed. Ranks are
+    doubled so that tied midranks stay integers."""
+    counts = [{} for _ in range(n1 + 1)]  # counts[k][sum] = subsets of size k
+    counts[0][0] = 1
+    for r in ranks:
+        for k in range(n1, 0, -1):
+            for total, c in counts[k - 1].items():
+                counts[k][total + r] = counts[k].get(total + r, 0) + c
+    mean = n1 * sum(ranks) / len(ranks)
+    deviation = abs(observed - mean)
+    extreme = sum(c for total, c in counts[n1].items() if abs(total - mean) >= deviation - 1e-9)
+    return min(1.0, extreme / math.comb(len(ranks), n1))
+
+
+def min_p_value(n1, n2):
+    """Smallest two-sided p-value the U test can give for these sample counts"""
+    return min(1.0, 2 / math.comb(n1 + n2, n1))
+
+
+def mann_whitney(a, b):
+    """Two-sided p-value of the Mann-Whitney U test: exact over the tied
+    ranks up to EXACT_LIMIT samples, else the normal approximation with tie
+    correction"""
+    n1, n2 = len(a), len(b)
+    ranked = sorted([(v, 0) for v in a] + [(v, 1) for v in b])
+    ranks = [0.0] * len(ranked)
+    tie_term = 0
+    i = 0
+    while i < len(ranked):
+        j = i
+        while j + 1 < len(ranked) and ranked[j + 1][0] == ranked[i][0]:
+            j += 1
+        for k in range(i, j + 1):
+            ranks[k] = (i + j) / 2 + 1
+        tie_term += (j - i + 1) ** 3 - (j - i + 1)
+        i = j + 1
+    r1 = sum(rank for rank, (_, group) in zip(ranks, ranked) if group == 0)
+    n = n1 + n2
+    if n <= EXACT_LIMIT:
+        return exact_rank_sum_p([round(2 * rank) for rank in ranks], n1, round(2 * r1))
+    u = r1 - n1 * (n1 + 1) / 2
+    variance = n1 * n2 / 12 * ((n + 1) - tie_term / (n * (n - 1)))
+    if variance <= 0:
+        return 1.0
+    z = (abs(u - n1 * n2 / 2) - 0.5) / math.sqrt(variance)
+    return min(1.0, math.erfc(max(z, 0) / math.sqrt(2)))
+
+
+def bootstrap_interval(base, new, confidence, iterations, rng):
+    """CI of median(new) / median(base)"""
+    ratios = []
+    for _ in range(iterations):
+        b = statistics.median(rng.choices(base, k=len(base)))
+        n = statistics.median(rng.choices(new, k=len(new)))
+        if b > 0:
+            ratios.append(n / b)
+    ratios.sort()
+    tail = (1 - confidence) / 2
+    return ratios[int(tail * (len(ratios) - 1))], ratios[int(math.ceil((1 - tail) * (len(ratios) - 1)))]
+
+
+def threshold_for(metric, args):
+    for pattern, value in args.metric_threshold:
+        if fnmatch.fnmatch(metric, pattern):
+            return value
+    return args.threshold
+
+
+def compare_metric(metric, base, new, args, rng):
+    base_median, new_median = statistics.median(base), statistics.median(new)
+    if base_median == 0:
+        ratio = 1.0 if new_median == 0 else math.inf
+    else:
+        ratio = new_median / base_median
+    threshold = threshold_for(metric, args)
+    entry = {"baseline_median": base_median, "median": new_median, "ratio": ratio,
+             "threshold": threshold, "samples": [len(base), len(new)]}
+
+    if len(base) < 2 or len(new) < 2:
+        # Deterministic metric: any change beyond the threshold counts
+        significant = True
+    elif args.method == "mann-whitney" and min_p_value(len(base), len(new)) >= args.alpha:
+        # No outcome could reach alpha; a test that can never fire would
+        # let any slowdown through, so judge by the threshold alone
+        entry["underpowered"] = True
+        significant = True
+    elif args.method == "bootstrap":
+        low, high = bootstrap_interval(base, new, 1 - args.alpha, args.bootstrap, rng)
+        entry["ci"] = [low, high]
+        significant = low > 1 or high < 1
+    else:
+        entry["p_value"] = mann_whitney(base, new)
+        significant = entry["p_value"] < args.alpha
+
+    if significant and ratio > 1 + threshold:
+        entry["verdict"] = "regression"
+    elif significant and ratio < 1 - threshold:
+        entry["verdict"] = "improvement"
+    else:
+        entry["verdict"] = "unchanged"
+    return entry
+
+
+def baseline_path(args):
+    return os.path.join(args.store, f"{args.name}.json")
+
+
+def record(args):
+    metrics = load_metrics(args.reports)
+    baseline = {
+        "schema": SCHEMA_VERSION,
+        "name": args.name,
+        "recorded": time.strftime("%Y-%m-%dT%H:%M:%S%z"),
+        "commit": git_commit(),
+        "machine": {"node": platform.node(), "processor": platform.machine(),
+                    "cpus": os.cpu_count(), "system": platform.system()},
+        "reports": [os.path.basename(p) for p in args.reports],
+        "metrics": {name: {"median": statistics.median(samples),
+                           "samples": thin(samples, args.max_samples)}
+                    for name, samples in sorted(metrics.items())},
+    }
+    os.makedirs(args.store, exist_ok=True)
+    with open(baseline_path(args), 'w') as f:
+        json.dump(baseline, f, indent=1)
+    print(f"[INFO] Recorded {len(metrics)} metrics as baseline '{args.name}': "
+          f"{baseline_path(args)}")
+    return 0
+
+
+def compare(args):
+    with open(baseline_path(args)) as f:
+        baseline = json.load(f)
+    if baseline.get("schema") != SCHEMA_VERSION:
+        print(f"[ERROR] {baseline_path(args)}: baseline schema {baseline.get('schema')}, "
+              f"expected {SCHEMA_VERSION}; record it again", file=sys.stderr)
+        return 2
+    if baseline["machine"]["node"] != platform.node():
+        print(f"[WARNING] Baseline was recorded on {baseline['machine']['node']}; "
+              f"timings from another machine are not comparable")
+
+    metrics = load_metrics(args.reports)
+    rng = random.Random(0)
+    results = {}
+    for name, stored in baseline["metrics"].items():
+        if args.only and not any(fnmatch.fnmatch(name, p) for p in args.only):
+            continue
+        if name not in metrics:
+            continue
+        results[name] = compare_metric(name, stored["samples"], metrics[name], args, rng)
+    missing = sorted(set(baseline["metrics"]) - set(metrics))
+    added = sorted(set(metrics) - set(baseline["metrics"]))
+
+    regressions = {n: r for n, r in results.items() if r["verdict"] == "regression"}
+    improvements = {n: r for n, r in results.items() if r["verdict"] == "improvement"}
+    for title, group in (("REGRESSION", regressions), ("IMPROVED", improvements)):
+        for name, entry in group.items():
+            evidence = (f"p={entry['p_value']:.2g}" if "p_value" in entry else
+                        f"CI [{entry['ci'][0]:.3f},{entry['ci'][1]:.3f}]" if "ci" in entry
+                        else "threshold only" if entry.get("underpowered")
+                        else "deterministic")
+            print(f"[{title}] {name}: {entry['baseline_median']:.6g} -> "
+                  f"{entry['median']:.6g} ({(entry['ratio'] - 1) * 100:+.1f}%, {evidence})")
+    underpowered = sorted(n for n, r in results.items() if r.get("underpowered"))
+    if underpowered:
+        needed = next(m for m in range(2, 100) if min_p_value(m, m) < args.alpha)
+        print(f"[WARNING] {len(underpowered)} metrics, e.g. {underpowered[0]}, have too few "
+              f"samples for p < {args.alpha} and were judged by --threshold alone; record "
+              f"and compare with at least {needed} runs per side")
+    if missing:
+        print(f"[WARNING] {len(missing)} baseline metrics not in this run, e.g. {missing[0]}")
+    if added:
+        print(f"[INFO] {len(added)} metrics have no baseline yet, e.g. {added[0]}")
+    print(f"[INFO] {len(results)} metrics compared against '{args.name}' "
+          f"(commit {(baseline.get('commit') or 'unknown')[:12]}): "
+          f"{len(regressions)} regressed, {len(improvements)} improved")
+
+    if args.out:
+        with open(args.out, 'w') as f:
+            json.dump({"baseline": args.name, "baseline_commit": baseline.get("commit"),
+                       "method": args.method, "alpha": args.alpha, "results": results,
+                       "missing": missing, "added": added}, f, indent=2)
+    return 1 if regressions else 0
+
+
+def metric_threshold(text):
+    pattern, _, value = text.partition('=')
+    try:
+        return pattern, float(value)
+    except ValueError:
+        raise argparse.ArgumentTypeError(f"expected PATTERN=FRACTION, got '{text}'")
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Store benchmark baselines and check new runs for regressions")
+    commands = parser.add_subparsers(dest='command', required=True)
+
+    def common(sub):
+        sub.add_argument('name', help='Baseline name, e.g. compile-functions or runtime')
+        sub.add_argument('reports', nargs='+', help='Benchmark report JSON files')
+        sub.add_argument('--store', default=DEFAULT_STORE,
+                         help='Baseline directory (default: baselines/)')
+
+    sub = commands.add_parser('record', help='Store reports as a baseline')
+    common(sub)
+    sub.add_argument('--max-samples', type=int, default=200,
+                     help='Samples kept per metric (default: 200)')
+
+    sub = commands.add_parser('compare', help='Compare reports against a baseline')
+    common(sub)
+    sub.add_argument('--method', choices=('mann-whitney', 'bootstrap'),
+                     default='mann-whitney', help='Significance test (default: mann-whitney)')
+    sub.add_argument('--alpha', type=float, default=0.01,
+                     help='Significance level (default: 0.01)')
+    sub.add_argument('--threshold', type=float, default=0.05,
+                     help='Relative change of the median that counts (default: 0.05)')
+    sub.add_argument('--metric-threshold', type=metric_threshold, action='append',
+                     default=[], metavar='PATTERN=FRACTION',
+                     help='Threshold for metrics matching a glob, e.g. "size/*=0"')
+    sub.add_argument('--only', action='append', default=[], metavar='PATTERN',
+                     help='Only compare metrics matching this glob')
+    sub.add_argument('--bootstrap', type=int, default=2000,
+                     help='Bootstrap resamples (default: 2000)')
+    sub.add_argument('--out', help='Write the comparison as JSON')
+    args = parser.parse_args()
+
+    try:
+        return record(args) if args.command == 'record' else compare(args)
+    except (OSError, ValueError) as e:
+        print(f"[ERROR] {e}", file=sys.stderr)
+        return 2
+
+
+if __name__ == "__main__":
+    sys.exit(main())
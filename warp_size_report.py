@@ -0,0 +1,219 @@
+#!/usr/bin/env python3
+"""
+warp_size_report.py - Per-function size impact of warp_aai obfuscation
+
+Compares an obfuscated binary (or object) with a baseline build of the same
+sources and attributes the growth:
+
+- per symbol, mapping renamed symbols back to their original names through
+  the pass's rename_map telemetry
+- per technique, using the inserted_symbols / modified_functions markers
+  the pass records for every symbol it adds or changes
+- per section, which also catches growth without a symbol of its own
+  (private string data, alignment padding)
+
+Symbol sizes come from llvm-nm --print-size, section sizes from llvm-size -A.
+
+EDUCATIONAL MVP ONLY - part of the warp_aai educational obfuscation toolchain.
+"""
+
+import argparse
+import json
+import shutil
+import subprocess
+import sys
+
+# Bucket for changed symbols the pass left no technique marker on
+UNATTRIBUTED = "unattributed"
+
+
+def find_tool(*names):
+    """First of the given tool names found on PATH"""
+    for name in names:
+        if shutil.which(name):
+            return name
+    raise RuntimeError(f"None of {', '.join(names)} found on PATH")
+
+
+def load_symbols(binary):
+    """Defined symbols with a size: {name: (size, nm type)}"""
+    nm = find_tool('llvm-nm', 'nm')
+    result = subprocess.run([nm, '--print-size', '--defined-only', '--radix=d', binary],
+                            capture_output=True, text=True)
+    if result.returncode != 0:
+        raise RuntimeError(f"{nm} failed for {binary}:\n{result.stderr}")
+
+    symbols = {}
+    for line in result.stdout.splitlines():
+        fields = line.split(None, 3)
+        if len(fields) != 4:
+            continue  # symbol without a size
+        _, size, kind, name = fields
+        # Local symbols may share a name across objects; sum them
+        total, _ = symbols.get(name, (0, kind))
+        symbols[name] = (total + int(size), kind)
+    return symbols
+
+
+def load_sections(binary):
+    """Allocated section sizes: {section: size}"""
+    size_tool = find_tool('llvm-size', 'size')
+    result = subprocess.run([size_tool, '-A', '-d', binary], capture_output=True, text=True)
+    if result.returncode != 0:
+        raise RuntimeError(f"{size_tool} failed for {binary}:\n{result.stderr}")
+
+    sections = {}
+    for line in result.stdout.splitlines():
+        fields = line.split()
+        if len(fields) == 3 and fields[0].startswith('.') and fields[1].isdigit():
+            sections[fields[0]] = sections.get(fields[0], 0) + int(fields[1])
+    return sections
+
+
+def load_markers(telemetry):
+    """Merge rename maps and technique markers from per-module telemetry"""
+    renames = {}
+    techniques = {}
+    for record in telemetry:
+        renames.update(record.get("rename_map", {}))
+        techniques.update(record.get("modified_functions", {}))
+        techniques.update(record.get("inserted_symbols", {}))
+    return renames, techniques
+
+
+def size_report(baseline, obfuscated, telemetry, top=20):
+    """Compare two builds; telemetry is a list of pass telemetry dicts"""
+    renames, techniques = load_markers(telemetry)
+    base_symbols = load_symbols(baseline)
+    obf_symbols = load_symbols(obfuscated)
+
+    rows = []
+    seen = set()
+    for name, (size, kind) in obf_symbols.items():
+        original = renames.get(name, name)
+        seen.add(original)
+        base_size = base_symbols.get(original, (0, kind))[0]
+        technique = techniques.get(name) or techniques.get(original)
+        if technique is None and original != name:
+            technique = "rename_globals"
+        rows.append({
+            "symbol": name,
+            "original": original,
+            "kind": kind,
+            "baseline_size": base_size,
+            "obfuscated_size": size,
+            "delta": size - base_size,
+            "technique": technique or UNATTRIBUTED,
+        })
+
+    # Symbols that disappeared (e.g. inlined differently)
+    for name, (size, kind) in base_symbols.items():
+        if name not in seen:
+            rows.append({
+                "symbol": None,
+                "original": name,
+                "kind": kind,
+                "baseline_size": size,
+                "obfuscated_size": 0,
+                "delta": -size,
+                "technique": UNATTRIBUTED,
+            })
+
+    by_technique = {}
+    for row in rows:
+        if not row["delta"] and row["technique"] == UNATTRIBUTED:
+            continue
+        by_technique[row["technique"]] = by_technique.get(row["technique"], 0) + row["delta"]
+
+    base_sections = load_sections(baseline)
+    obf_sections = load_sections(obfuscated)
+    sections = {
+        name: {
+            "baseline_size": base_sections.get(name, 0),
+            "obfuscated_size": obf_sections.get(name, 0),
+            "delta": obf_sections.get(name, 0) - base_sections.get(name, 0),
+        }
+        for name in sorted(set(base_sections) | set(obf_sections))
+    }
+
+    symbol_delta = sum(row["delta"] for row in rows)
+    section_delta = sum(entry["delta"] for entry in sections.values())
+    changed = sorted((row for row in rows if row["delta"]),
+                     key=lambda row: abs(row["delta"]), reverse=True)
+
+    return {
+        "baseline": baseline,
+        "obfuscated": obfuscated,
+        "totals": {
+            "symbol_delta": symbol_delta,
+            "section_delta": section_delta,
+            # Growth no symbol accounts for
+            "unsymbolized_delta": section_delta - symbol_delta,
+        },
+        "by_technique": dict(sorted(by_technique.items())),
+        "sections": {name: entry for name, entry in sections.items() if entry["delta"]},
+        "symbols": changed[:top] if top else changed,
+    }
+
+
+def print_summary(report):
+    totals = report["totals"]
+    print(f"[INFO] Size delta: {totals['section_delta']:+d} bytes "
+          f"({totals['symbol_delta']:+d} in symbols, "
+          f"{totals['unsymbolized_delta']:+d} unsymbolized)")
+    for technique, delta in report["by_technique"].items():
+        print(f"[INFO]   {technique:<18} {delta:+d} bytes")
+    for name, entry in report["sections"].items():
+        print(f"[INFO] Section {name}: {entry['baseline_size']} -> "
+              f"{entry['obfuscated_size']} ({entry['delta']:+d})")
+    for row in report["symbols"]:
+        label = row["symbol"] or row["original"]
+        if row["symbol"] and row["symbol"] != row["original"]:
+            label = f"{row['symbol']} (was {row['original']})"
+        print(f"[INFO] {label}: {row['baseline_size']} -> {row['obfuscated_size']} "
+              f"({row['delta']:+d}, {row['technique']})")
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Attribute obfuscated binary growth to functions, sections and techniques")
+    parser.add_argument('--baseline', required=True,
+                        help='Binary or object built without the obfuscation pass')
+    parser.add_argument('--obfuscated', required=True,
+                        help='Obfuscated binary or object built from the same sources')
+    parser.add_argument('--telemetry', nargs='*', default=[],
+                        help='Pass telemetry files holding the rename map and markers')
+    parser.add_argument('--out', default='warp_size_report.json',
+                        help='Report path (default: warp_size_report.json)')
+    parser.add_argument('--top', type=int, default=20,
+                        help='Number of changed symbols to list, 0 for all (default: 20)')
+    parser.add_argument('--quiet', '-q', action='store_true',
+                        help='Only write the report file')
+    args = parser.parse_args()
+
+    telemetry = []
+    for path in args.telemetry:
+        try:
+            with open(path, 'r') as f:
+                telemetry.append(json.load(f))
+        except (OSError, ValueError) as e:
+            print(f"[WARNING] Could not parse {path}: {e}", file=sys.stderr)
+
+    try:
+        report = size_report(args.baseline, args.obfuscated, telemetry, args.top)
+    except RuntimeError as e:
+        print(f"[ERROR] {e}", file=sys.stderr)
+        return 1
+
+    with open(args.out, 'w') as f:
+        json.dump(report, f, indent=2)
+
+    if not args.quiet:
+        print_summary(report)
+        print(f"[INFO] Size report saved: {args.out}")
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,286 @@
+#!/usr/bin/env python3
+"""
+warp_sqlite_bench.py - End-to-end obfuscation benchmark on SQLite
+
+example.c and the workloads are too small to show how the pass scales.
+The SQLite amalgamation is one realistic, very large translation unit
+(sqlite3.c: ~250k lines, thousands of functions and string constants),
+and its speedtest1 program is a standard runtime benchmark.
+
+The sources are not part of this repository. Download the amalgamation
+zip and speedtest1.c (test/speedtest1.c in the SQLite source tree, same
+version) from https://sqlite.org/download.html and put sqlite3.c,
+sqlite3.h and speedtest1.c in one directory, third_party/sqlite/ by
+default.
+
+The harness builds speedtest1 + sqlite3 once without the pass and once per
+configuration, recording for every obfuscated build the pass wall time,
+the pass's own time and peak RSS (from its telemetry) and the binary size.
+It then runs all builds --repeat times, interleaved in a shuffled order,
+checks that each reports the same --verify hash as the baseline, and
+compares the TOTAL time and every speedtest1 test's time.
+
+EDUCATIONAL MVP ONLY - part of the warp_aai educational obfuscation toolchain.
+"""
+
+import argparse
+import json
+import os
+import random
+import re
+import shutil
+import statistics
+import subprocess
+import sys
+import tempfile
+import time
+
+from warp_aai import TECHNIQUES
+from warp_workloads import BASELINE, QuietToolchain, geomean, pin
+
+DEFAULT_SQLITE_DIR = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                                  'third_party', 'sqlite')
+SOURCES = ("sqlite3.c", "speedtest1.c")
+# Keep the build free of threads and dlopen so only libc and libm are needed
+SQLITE_CFLAGS = ['-O2', '-DSQLITE_THREADSAFE=0', '-DSQLITE_OMIT_LOAD_EXTENSION']
+
+# " 100 - 50000 INSERTs into table with no index.............    0.071s"
+TEST_LINE = re.compile(r'^\s*(\d+) - (.*?)\.{2,}\s+([\d.]+)s\s*$')
+TOTAL_LINE = re.compile(r'^\s*TOTAL\.{2,}\s+([\d.]+)s\s*$')
+VERIFY_LINE = re.compile(r'^Verification Hash:\s*(\S+)', re.MULTILINE)
+
+
+class SqliteToolchain(QuietToolchain):
+    def native_compiler(self, target):
+        compiler, flags = super().native_compiler(target)
+        return compiler, flags + ['-lm']
+
+
+def sqlite_version(sqlite_dir):
+    with open(os.path.join(sqlite_dir, 'sqlite3.h'), errors='replace') as f:
+        match = re.search(r'#define SQLITE_VERSION\s+"([^"]+)"', f.read())
+    return match.group(1) if match else None
+
+
+def build(args, build_dir):
+    """Returns ({config: binary}, {config: build metrics})"""
+    toolchain = SqliteToolchain()
+    toolchain.verbose = args.verbose
+    toolchain.cflags = SQLITE_CFLAGS + [f'-I{args.sqlite_dir}']
+    sources = [os.path.join(args.sqlite_dir, name) for name in SOURCES]
+
+    start = time.perf_counter()
+    bitcode = toolchain.link_bitcode(toolchain.compile_to_bitcode(sources, build_dir),
+                                     os.path.join(build_dir, "speedtest1.bc"))
+    print(f"[INFO] Compiled SQLite {args.version} to bitcode "
+          f"in {time.perf_counter() - start:.1f}s")
+
+    binaries = {BASELINE: os.path.join(build_dir, BASELINE)}
+    toolchain.compile_to_native(bitcode, binaries[BASELINE])
+    metrics = {BASELINE: {"binary_bytes": os.path.getsize(binaries[BASELINE])}}
+
+    for config in args.configs:
+        toolchain.techniques = [] if config == "all" else [config]
+        obfuscated = os.path.join(build_dir, f"{config}.bc")
+        telemetry_file = os.path.join(build_dir, f"{config}.json")
+        start = time.perf_counter()
+        toolchain.run_obfuscation_pass(bitcode, obfuscated, args.pass_lib, args.xor_key,
+                                       args.bogus_count, args.cycles, args.seed,
+                                       telemetry_file=telemetry_file)
+        wall = time.perf_counter() - start
+        with open(telemetry_file) as f:
+            telemetry = json.load(f)
+
+        binaries[config] = os.path.join(build_dir, config)
+        start = time.perf_counter()
+        toolchain.compile_to_native(obfuscated, binaries[config])
+        metrics[config] = {
+            "obfuscation_seconds": wall,
+            "pass_seconds": telemetry.get("total_seconds"),
+            "technique_seconds": telemetry.get("technique_seconds", {}),
+            "peak_rss_bytes": telemetry.get("peak_rss_bytes"),
+            "codegen_seconds": time.perf_counter() - start,
+            "instructions_before": telemetry.get("instructions_before"),
+            "instructions_after": telemetry.get("instructions_after"),
+            "binary_bytes": os.path.getsize(binaries[config]),
+        }
+        print(f"[INFO] Built [{config}]: pass {wall:.1f}s, peak RSS "
+              f"{(telemetry.get('peak_rss_bytes') or 0) / (1 << 20):.0f} MiB, "
+              f"{metrics[config]['binary_bytes'] / 1024:.0f} KiB")
+    return binaries, metrics
+
+
+def run_speedtest(binary, args, work_dir):
+    """(total seconds, {test: seconds}, verify hash) of one run"""
+    cmd = [binary] + args.speedtest_args + [os.path.join(work_dir, "speedtest1.db")]
+    result = subprocess.run(cmd, capture_output=True, text=True, cwd=work_dir,
+                            preexec_fn=pin(args.cpu))
+    if result.returncode != 0:
+        raise RuntimeError(f"{binary} exited with {result.returncode}:\n{result.stderr}")
+    total, tests = None, {}
+    for line in result.stdout.splitlines():
+        match = TEST_LINE.match(line)
+        if match:
+            tests[f"{match.group(1)} {match.group(2).strip()}"] = float(match.group(3))
+            continue
+        match = TOTAL_LINE.match(line)
+        if match:
+            total = float(match.group(1))
+    if total is None:
+        raise RuntimeError(f"{binary}: no TOTAL line in speedtest1 output")
+    verify = VERIFY_LINE.search(result.stdout)
+    return total, tests, verify.group(1) if verify else None
+
+
+def measure(binaries, args, work_dir):
+    """Returns ({config: {"total": [s], "tests": {test: [s]}}}, [mismatch messages])"""
+    rng = random.Random(args.seed)
+    # Warm-up run doubles as the reference hash
+    _, _, reference = run_speedtest(binaries[BASELINE], args, work_dir)
+    samples = {config: {"total": [], "tests": {}} for config in binaries}
+    mismatches = []
+    failed = set()
+    for _ in range(args.repeat):
+        order = list(binaries)
+        rng.shuffle(order)
+        for config in order:
+            if config in failed:
+                continue
+            total, tests, verify = run_speedtest(binaries[config], args, work_dir)
+            if verify != reference:
+                failed.add(config)
+                mismatches.append(f"[{config}]: verification hash {verify} differs from "
+                                  f"baseline {reference}")
+                continue
+            samples[config]["total"].append(total)
+            for test, seconds in tests.items():
+                samples[config]["tests"].setdefault(test, []).append(seconds)
+    return {c: s for c, s in samples.items() if c not in failed}, mismatches
+
+
+def analyze(samples, configs):
+    base = samples[BASELINE]
+    results = {BASELINE: {"total_seconds": statistics.median(base["total"])}}
+    for config in configs:
+        if config not in samples:
+            continue
+        obf = samples[config]
+        tests = {test: statistics.median(obf["tests"][test]) /
+                 statistics.median(base["tests"][test])
+                 for test in base["tests"] if test in obf["tests"]
+                 and statistics.median(base["tests"][test]) > 0}
+        results[config] = {
+            "total_seconds": statistics.median(obf["total"]),
+            "slowdown": statistics.median(obf["total"]) / statistics.median(base["total"]),
+            "test_slowdowns": tests,
+            "geomean_test_slowdown": geomean(tests.values()) if tests else None,
+            "slowest_tests": sorted(tests, key=tests.get, reverse=True)[:5],
+        }
+    return results
+
+
+def print_table(metrics, results, configs):
+    header = (f"{'config':<18} {'pass s':>8} {'peak MiB':>9} {'size KiB':>9} "
+              f"{'total s':>8} {'slowdown':>9} {'geomean':>8}")
+    print(header)
+    print("-" * len(header))
+    for config in [BASELINE] + configs:
+        built = metrics.get(config, {})
+        ran = results.get(config)
+        pass_s = f"{built['obfuscation_seconds']:.2f}" if "obfuscation_seconds" in built else ""
+        peak = f"{built['peak_rss_bytes'] / (1 << 20):.0f}" if built.get("peak_rss_bytes") else ""
+        line = (f"{config:<18} {pass_s:>8} {peak:>9} "
+                f"{built.get('binary_bytes', 0) / 1024:>9.0f} ")
+        if not ran:
+            print(line + f"{'FAILED':>8}")
+            continue
+        line += f"{ran['total_seconds']:>8.3f} "
+        if config != BASELINE:
+            line += (f"{ran['slowdown']:>8.3f}x "
+                     f"{ran['geomean_test_slowdown'] or 0:>7.3f}x")
+        print(line)
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Obfuscate SQLite's speedtest1 and measure build and runtime cost")
+    parser.add_argument('--pass-lib', required=True,
+                        help='Path to compiled obfuscation pass library')
+    parser.add_argument('--sqlite-dir', default=DEFAULT_SQLITE_DIR,
+                        help='Directory with sqlite3.c, sqlite3.h and speedtest1.c '
+                             '(default: third_party/sqlite)')
+    parser.add_argument('--configs', type=lambda v: [c for c in v.split(',') if c],
+                        default=list(TECHNIQUES) + ["all"],
+                        help='Configurations: technique names and/or "all" '
+                             '(default: each technique, then all)')
+    parser.add_argument('--speedtest-args', default='--size 50 --memdb --verify',
+                        help='speedtest1 options (default: "--size 50 --memdb --verify")')
+    parser.add_argument('--repeat', type=int, default=7,
+                        help='speedtest1 runs per build (default: 7, enough for '
+                             'warp_regress.py to reach p < 0.01)')
+    parser.add_argument('--cpu', type=int,
+                        help='Pin every run to this CPU (default: no pinning)')
+    parser.add_argument('--xor-key', type=int, default=170)
+    parser.add_argument('--bogus-count', type=int, default=2)
+    parser.add_argument('--cycles', type=int, default=1)
+    parser.add_argument('--seed', type=int, default=0,
+                        help='Pass seed; also seeds run order (default: 0)')
+    parser.add_argument('--out', default='warp_sqlite.json',
+                        help='Report path (default: warp_sqlite.json)')
+    parser.add_argument('--keep-builds', metavar='DIR',
+                        help='Build into DIR and keep the binaries')
+    parser.add_argument('--verbose', '-v', action='store_true')
+    args = parser.parse_args()
+    args.pass_lib = os.path.abspath(args.pass_lib)
+    args.sqlite_dir = os.path.abspath(args.sqlite_dir)
+    args.speedtest_args = args.speedtest_args.split()
+
+    unknown = set(args.configs) - set(TECHNIQUES) - {"all"}
+    if unknown:
+        parser.error(f"unknown configuration(s): {', '.join(sorted(unknown))}")
+    missing = [name for name in SOURCES + ("sqlite3.h",)
+               if not os.path.exists(os.path.join(args.sqlite_dir, name))]
+    if missing:
+        print(f"[ERROR] {', '.join(missing)} not found in {args.sqlite_dir}; download "
+              f"the amalgamation and test/speedtest1.c from https://sqlite.org/download.html",
+              file=sys.stderr)
+        return 1
+    args.version = sqlite_version(args.sqlite_dir)
+
+    build_dir = args.keep_builds or tempfile.mkdtemp(prefix="warp_sqlite_")
+    try:
+        binaries, metrics = build(args, build_dir)
+        samples, mismatches = measure(binaries, args, build_dir)
+    except RuntimeError as e:
+        print(f"[ERROR] {e}", file=sys.stderr)
+        return 1
+    finally:
+        if not args.keep_builds:
+            shutil.rmtree(build_dir, ignore_errors=True)
+
+    results = analyze(samples, args.configs)
+    report = {
+        "parameters": {
+            "sqlite_version": args.version, "configs": args.configs,
+            "speedtest_args": args.speedtest_args, "repeat": args.repeat, "cpu": args.cpu,
+            "xor_key": args.xor_key, "bogus_count": args.bogus_count,
+            "cycles": args.cycles, "seed": args.seed,
+        },
+        "builds": metrics,
+        "speedtest": results,
+        "mismatches": mismatches,
+        # Per-run seconds, for statistical comparison (warp_regress.py)
+        "samples": samples,
+    }
+    with open(args.out, 'w') as f:
+        json.dump(report, f, indent=2)
+
+    print_table(metrics, results, args.configs)
+    for message in mismatches:
+        print(f"[ERROR] {message}", file=sys.stderr)
+    print(f"[INFO] SQLite report saved: {args.out}")
+    return 1 if mismatches else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
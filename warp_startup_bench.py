@@ -0,0 +1,285 @@
+#!/usr/bin/env python3
+"""
+warp_startup_bench.py - Startup latency of string decode strategies
+
+String protection costs the most at process start: the eager strategy
+decodes every string before main, the lazy ones defer the work to the
+first access. This harness generates programs with N protected strings of
+S bytes each (warp_irgen -main), builds them once without the pass and once
+per -obf-string-decode strategy, then runs every build many times in a
+shuffled, interleaved order and records per run:
+
+- exec -> main:       monotonic clock before spawning to main's first
+                      clock read (process creation, loading, constructors)
+- main -> request:    main's first clock read to the end of its first
+                      request, which touches 1/F of the strings
+- minor/major faults of the child, from wait4()
+- resident set size after the request, which main reads from
+  /proc/self/statm (wait4's ru_maxrss would report the forking harness's
+  high-water mark, which survives exec)
+
+Spawn overhead of the harness itself, including faults taken between fork
+and exec, is the same for every build, so compare strategies by their
+delta against the baseline.
+
+Linux / POSIX only (CLOCK_MONOTONIC shared with the child, os.wait4).
+
+EDUCATIONAL MVP ONLY - part of the warp_aai educational obfuscation toolchain.
+"""
+
+import argparse
+import json
+import os
+import random
+import shutil
+import statistics
+import subprocess
+import sys
+import tempfile
+import time
+
+from warp_aai import STRING_DECODE_STRATEGIES, WarpAAIToolchain
+from warp_bench import find_irgen, run
+from warp_workloads import QuietToolchain, pin
+
+BASELINE = "baseline"
+PAGE_SIZE = os.sysconf("SC_PAGE_SIZE") if hasattr(os, "sysconf") else 4096
+METRICS = ("exec_to_main_ns", "main_to_request_ns", "exec_to_request_ns",
+           "minor_faults", "major_faults", "rss_bytes")
+
+
+def int_list(text):
+    return [int(v) for v in text.split(',') if v]
+
+
+def build_programs(args, irgen, build_dir):
+    """Returns {(strings, size): {config: binary}}"""
+    toolchain = QuietToolchain()
+    toolchain.verbose = args.verbose
+    toolchain.techniques = ["strings"]
+    toolchain.runtime_lib = args.runtime_lib
+
+    builds = {}
+    for count in args.strings:
+        for size in args.sizes:
+            work = os.path.join(build_dir, f"n{count}_s{size}")
+            os.makedirs(work, exist_ok=True)
+            module = os.path.join(work, "program.bc")
+            run([irgen, '-main', '-string-use=strlen', f'-functions={args.functions}',
+                 f'-request-functions={args.request_functions}', '-blocks=1',
+                 f'-globals={args.functions}', f'-strings={count}',
+                 f'-string-length={size}', f'-seed={args.seed}', '-o', module])
+
+            binaries = {BASELINE: os.path.join(work, BASELINE)}
+            toolchain.string_decode = "eager"
+            toolchain.compile_to_native(module, binaries[BASELINE])
+            for strategy in args.strategies:
+                toolchain.string_decode = strategy
+                obfuscated = os.path.join(work, f"{strategy}.bc")
+                toolchain.run_obfuscation_pass(
+                    module, obfuscated, args.pass_lib, args.xor_key, 0, 1, args.seed,
+                    telemetry_file=os.path.join(work, f"{strategy}.json"))
+                binaries[strategy] = os.path.join(work, strategy)
+                toolchain.compile_to_native(obfuscated, binaries[strategy])
+            builds[(count, size)] = binaries
+            print(f"[INFO] Built N={count} S={size}: {BASELINE} + "
+                  f"{len(args.strategies)} strategies")
+    return builds
+
+
+def run_once(binary, cpu):
+    """One timed run; returns (sample dict, request result) or (None, error)"""
+    spawn_ns = time.monotonic_ns()
+    proc = subprocess.Popen([binary], stdout=subprocess.PIPE,
+                            stderr=subprocess.DEVNULL, preexec_fn=pin(cpu))
+    out = proc.stdout.read()
+    proc.stdout.close()
+    _, status, usage = os.wait4(proc.pid, 0)
+    proc.returncode = os.waitstatus_to_exitcode(status)
+    if proc.returncode != 0:
+        return None, f"exit code {proc.returncode}"
+
+    # The report line is the last one; strings may be printed before it
+    fields = out.decode(errors='replace').strip().splitlines()[-1:]
+    fields = fields[0].split() if fields else []
+    if len(fields) != 5 or fields[0] != "warp_startup":
+        return None, "no warp_startup line in output"
+    main_ns, request_ns = int(fields[1]), int(fields[2])
+    sample = {
+        "exec_to_main_ns": main_ns - spawn_ns,
+        "main_to_request_ns": request_ns - main_ns,
+        "exec_to_request_ns": request_ns - spawn_ns,
+        "minor_faults": usage.ru_minflt,
+        "major_faults": usage.ru_majflt,
+        "rss_bytes": int(fields[4]) * PAGE_SIZE,
+    }
+    return sample, fields[3]
+
+
+def measure(builds, args):
+    """Returns ({(strings, size): {config: [sample]}}, [mismatch messages])"""
+    rng = random.Random(args.seed)
+    samples = {}
+    mismatches = []
+    for key, binaries in builds.items():
+        # Warm-up run doubles as the reference request result
+        _, reference = run_once(binaries[BASELINE], args.cpu)
+        runs = {config: [] for config in binaries}
+        failed = set()
+        for _ in range(args.runs):
+            order = list(binaries)
+            rng.shuffle(order)
+            for config in order:
+                if config in failed:
+                    continue
+                sample, result = run_once(binaries[config], args.cpu)
+                if sample is None or result != reference:
+                    failed.add(config)
+                    mismatches.append(f"N={key[0]} S={key[1]} [{config}]: "
+                                      f"{result if sample is None else 'result differs from baseline'}")
+                    continue
+                runs[config].append(sample)
+        samples[key] = {config: r for config, r in runs.items() if config not in failed}
+        print(f"[INFO] Measured N={key[0]} S={key[1]}: {args.runs} runs per build")
+    return samples, mismatches
+
+
+def percentile(values, fraction):
+    ordered = sorted(values)
+    return ordered[min(len(ordered) - 1, int(fraction * len(ordered)))]
+
+
+def summarize(samples, configs):
+    """Per grid point and config: median/p90/p99/mean of every metric"""
+    results = []
+    for (count, size), runs in samples.items():
+        baseline = runs.get(BASELINE)
+        for config in [BASELINE] + configs:
+            if config not in runs:
+                results.append({"strings": count, "string_length": size,
+                                "strategy": config, "failed": True})
+                continue
+            entry = {"strings": count, "string_length": size, "strategy": config,
+                     "runs": len(runs[config]), "samples": {}}
+            for metric in METRICS:
+                values = [s[metric] for s in runs[config]]
+                # Per-run values, for statistical comparison (warp_regress.py)
+                entry["samples"][metric] = values
+                entry[metric] = {
+                    "median": statistics.median(values),
+                    "p90": percentile(values, 0.90),
+                    "p99": percentile(values, 0.99),
+                    "mean": statistics.fmean(values),
+                }
+                if baseline and config != BASELINE:
+                    entry[metric]["median_delta"] = (
+                        entry[metric]["median"] -
+                        statistics.median(s[metric] for s in baseline))
+            results.append(entry)
+    return results
+
+
+def print_table(results):
+    header = (f"{'N':>7} {'S':>6} {'strategy':<11} {'exec->main us':>14} {'delta':>9} "
+              f"{'main->req us':>13} {'delta':>9} {'p99 exec->req':>14} "
+              f"{'minflt':>7} {'rss KiB':>8}")
+    print(header)
+    print("-" * len(header))
+
+    def median_us(stats):
+        return f"{stats['median'] / 1000:.1f}"
+
+    def delta_us(stats):
+        return f"{stats['median_delta'] / 1000:+.1f}" if "median_delta" in stats else ""
+
+    for entry in results:
+        prefix = f"{entry['strings']:>7} {entry['string_length']:>6} {entry['strategy']:<11}"
+        if entry.get("failed"):
+            print(f"{prefix} {'FAILED':>14}")
+            continue
+        to_main = entry["exec_to_main_ns"]
+        to_request = entry["main_to_request_ns"]
+        print(f"{prefix} {median_us(to_main):>14} {delta_us(to_main):>9} "
+              f"{median_us(to_request):>13} {delta_us(to_request):>9} "
+              f"{entry['exec_to_request_ns']['p99'] / 1000:>14.1f} "
+              f"{entry['minor_faults']['median']:>7.0f} "
+              f"{entry['rss_bytes']['median'] / 1024:>8.0f}")
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Measure process startup latency under each string decode strategy")
+    parser.add_argument('--pass-lib', required=True,
+                        help='Path to compiled obfuscation pass library')
+    parser.add_argument('--runtime-lib',
+                        help='warp_rt runtime (default: libwarp_rt.a next to --pass-lib)')
+    parser.add_argument('--irgen',
+                        help='warp_irgen binary (default: build/bin, _build/bin, then PATH)')
+    parser.add_argument('--strategies', type=lambda v: [s for s in v.split(',') if s],
+                        default=list(STRING_DECODE_STRATEGIES),
+                        help='Comma-separated decode strategies (default: all)')
+    parser.add_argument('--strings', type=int_list, default=[100, 1000, 10000],
+                        help='Comma-separated string counts N (default: 100,1000,10000)')
+    parser.add_argument('--sizes', type=int_list, default=[16, 256],
+                        help='Comma-separated string lengths S (default: 16,256)')
+    parser.add_argument('--functions', type=int, default=64,
+                        help='Functions the strings are spread over (default: 64)')
+    parser.add_argument('--request-functions', type=int, default=1,
+                        help='Functions the first request calls (default: 1)')
+    parser.add_argument('--runs', type=int, default=1000,
+                        help='Runs per build (default: 1000)')
+    parser.add_argument('--cpu', type=int,
+                        help='Pin every run to this CPU (default: no pinning)')
+    parser.add_argument('--xor-key', type=int, default=170)
+    parser.add_argument('--seed', type=int, default=0,
+                        help='Generator and pass seed; also seeds run order (default: 0)')
+    parser.add_argument('--out', default='warp_startup.json',
+                        help='Report path (default: warp_startup.json)')
+    parser.add_argument('--keep-builds', metavar='DIR',
+                        help='Build into DIR and keep the binaries')
+    parser.add_argument('--verbose', '-v', action='store_true')
+    args = parser.parse_args()
+    args.pass_lib = os.path.abspath(args.pass_lib)
+    args.runtime_lib = args.runtime_lib or WarpAAIToolchain.default_runtime_lib(args.pass_lib)
+
+    unknown = set(args.strategies) - set(STRING_DECODE_STRATEGIES)
+    if unknown:
+        parser.error(f"unknown strategy(ies): {', '.join(sorted(unknown))}")
+    if not hasattr(os, "wait4"):
+        print("[ERROR] os.wait4 is unavailable; this harness needs a POSIX system",
+              file=sys.stderr)
+        return 1
+
+    build_dir = args.keep_builds or tempfile.mkdtemp(prefix="warp_startup_")
+    try:
+        builds = build_programs(args, find_irgen(args.irgen), build_dir)
+        samples, mismatches = measure(builds, args)
+    except RuntimeError as e:
+        print(f"[ERROR] {e}", file=sys.stderr)
+        return 1
+    finally:
+        if not args.keep_builds:
+            shutil.rmtree(build_dir, ignore_errors=True)
+
+    results = summarize(samples, args.strategies)
+    report = {
+        "parameters": {
+            "strategies": args.strategies, "strings": args.strings, "sizes": args.sizes,
+            "functions": args.functions, "request_functions": args.request_functions,
+            "runs": args.runs, "cpu": args.cpu, "xor_key": args.xor_key, "seed": args.seed,
+        },
+        "results": results,
+        "mismatches": mismatches,
+    }
+    with open(args.out, 'w') as f:
+        json.dump(report, f, indent=2)
+
+    print_table(results)
+    for message in mismatches:
+        print(f"[ERROR] {message}", file=sys.stderr)
+    print(f"[INFO] Startup report saved: {args.out}")
+    return 1 if mismatches else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
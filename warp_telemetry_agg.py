@@ -0,0 +1,261 @@
+#!/usr/bin/env python3
+"""
+warp_telemetry_agg.py - Build-wide aggregation of warp_aai pass telemetry
+
+Every SimpleObfPass invocation leaves one JSON telemetry file per module
+(warp_pass_telemetry_<hash>_<pid>.json, see -obf-telemetry-dir). This tool
+merges any number of them into a single build report with:
+
+- totals across all modules
+- per-technique timing percentiles
+- the slowest modules
+- modules whose instruction growth is far outside the build's norm
+- instruction and memory growth per technique and per cycle, plus the
+  largest peak RSS of any pass run
+
+EDUCATIONAL MVP ONLY - part of the warp_aai educational obfuscation toolchain.
+"""
+
+import argparse
+import fnmatch
+import json
+import math
+import os
+import sys
+from concurrent.futures import ProcessPoolExecutor
+
+# Names the pass (-obf-telemetry-dir) and warp_aai.py --telemetry-dir write;
+# the aggregate report itself must never match
+TELEMETRY_PATTERN = "warp_pass_telemetry_*.json"
+
+# Files per worker task; small files are cheaper to parse than to ship
+# between processes one at a time
+CHUNK_SIZE = 256
+
+SUMMED_FIELDS = (
+    "strings_obf_count",
+    "fake_funcs_inserted",
+    "total_seconds",
+    "instructions_before",
+    "instructions_after",
+)
+
+
+# Per-sample deltas summed by technique and by cycle (see "growth" telemetry)
+GROWTH_FIELDS = ("instructions", "functions", "globals", "malloc_bytes", "rss_bytes")
+
+
+def collect_files(paths, exclude=None):
+    """Expand directories (recursively) into telemetry file paths, leaving
+    out exclude (the report being written)"""
+    files = []
+    for path in paths:
+        if os.path.isdir(path):
+            for dirpath, _, filenames in os.walk(path):
+                for fn in fnmatch.filter(filenames, TELEMETRY_PATTERN):
+                    files.append(os.path.join(dirpath, fn))
+        else:
+            files.append(path)
+    if exclude:
+        exclude = os.path.realpath(exclude)
+        files = [f for f in files if os.path.realpath(f) != exclude]
+    return files
+
+
+def load_chunk(paths):
+    """Parse a batch of telemetry files; returns (records, unreadable paths)"""
+    records = []
+    unreadable = []
+    for path in paths:
+        try:
+            with open(path, 'r') as f:
+                data = json.load(f)
+        except (OSError, ValueError):
+            unreadable.append(path)
+            continue
+        data["telemetry_file"] = path
+        records.append(data)
+    return records, unreadable
+
+
+def load_all(files, jobs):
+    """Load telemetry files, in parallel once there are enough of them"""
+    chunks = [files[i:i + CHUNK_SIZE] for i in range(0, len(files), CHUNK_SIZE)]
+    if jobs <= 1 or len(chunks) <= 1:
+        results = map(load_chunk, chunks)
+    else:
+        with ProcessPoolExecutor(max_workers=jobs) as pool:
+            results = list(pool.map(load_chunk, chunks))
+
+    records = []
+    unreadable = []
+    for chunk_records, chunk_unreadable in results:
+        records.extend(chunk_records)
+        unreadable.extend(chunk_unreadable)
+    return records, unreadable
+
+
+def percentile(sorted_values, pct):
+    """Nearest-rank percentile of an ascending list"""
+    if not sorted_values:
+        return 0.0
+    rank = max(1, math.ceil(pct / 100.0 * len(sorted_values)))
+    return sorted_values[rank - 1]
+
+
+def module_name(record):
+    return record.get("source_filename") or record.get("module") or record["telemetry_file"]
+
+
+def growth_ratio(record):
+    before = record.get("instructions_before", 0)
+    after = record.get("instructions_after", 0)
+    return after / before if before else None
+
+
+def growth_breakdown(records):
+    """Sum the before/after deltas of every growth sample by technique and cycle"""
+    by_technique = {}
+    by_cycle = {}
+    for record in records:
+        for sample in record.get("growth", []):
+            before = sample.get("before", {})
+            after = sample.get("after", {})
+            for key, bucket in ((sample.get("technique"), by_technique),
+                                (str(sample.get("cycle")), by_cycle)):
+                sums = bucket.setdefault(key, dict.fromkeys(GROWTH_FIELDS, 0))
+                for field in GROWTH_FIELDS:
+                    sums[field] += after.get(field, 0) - before.get(field, 0)
+    return by_technique, by_cycle
+
+
+def aggregate(records, top):
+    """Reduce per-module records to the build report"""
+    totals = {"modules": len(records)}
+    for field in SUMMED_FIELDS:
+        totals[field] = sum(r.get(field, 0) for r in records)
+    totals["total_seconds"] = round(totals["total_seconds"], 6)
+    totals["max_peak_rss_bytes"] = max((r.get("peak_rss_bytes", 0) for r in records), default=0)
+
+    # Per-technique timing distribution
+    per_technique = {}
+    for record in records:
+        for name, seconds in record.get("technique_seconds", {}).items():
+            per_technique.setdefault(name, []).append(seconds)
+
+    technique_stats = {}
+    for name, values in sorted(per_technique.items()):
+        values.sort()
+        technique_stats[name] = {
+            "sum": round(sum(values), 6),
+            "p50": percentile(values, 50),
+            "p90": percentile(values, 90),
+            "p99": percentile(values, 99),
+            "max": values[-1],
+        }
+
+    slowest = sorted(records, key=lambda r: r.get("total_seconds", 0), reverse=True)[:top]
+
+    # Growth outliers: Tukey far-out fence (Q3 + 3 * IQR) on after/before
+    ratios = sorted(g for g in map(growth_ratio, records) if g is not None)
+    fence = None
+    outliers = []
+    if ratios:
+        q1 = percentile(ratios, 25)
+        q3 = percentile(ratios, 75)
+        fence = q3 + 3 * (q3 - q1)
+        flagged = [r for r in records
+                   if growth_ratio(r) is not None and growth_ratio(r) > fence]
+        outliers = sorted(flagged, key=growth_ratio, reverse=True)[:top]
+
+    growth_by_technique, growth_by_cycle = growth_breakdown(records)
+
+    return {
+        "totals": totals,
+        "technique_seconds": technique_stats,
+        "growth_by_technique": growth_by_technique,
+        "growth_by_cycle": growth_by_cycle,
+        "slowest_modules": [
+            {"module": module_name(r), "total_seconds": r.get("total_seconds", 0),
+             "telemetry_file": r["telemetry_file"]}
+            for r in slowest
+        ],
+        "growth": {
+            "median_ratio": percentile(ratios, 50) if ratios else None,
+            "outlier_fence": fence,
+            "outliers": [
+                {"module": module_name(r), "ratio": round(growth_ratio(r), 3),
+                 "instructions_before": r.get("instructions_before", 0),
+                 "instructions_after": r.get("instructions_after", 0),
+                 "telemetry_file": r["telemetry_file"]}
+                for r in outliers
+            ],
+        },
+    }
+
+
+def print_summary(report):
+    totals = report["totals"]
+    print(f"[INFO] Modules: {totals['modules']}")
+    print(f"[INFO] Strings obfuscated: {totals['strings_obf_count']}")
+    print(f"[INFO] Fake functions added: {totals['fake_funcs_inserted']}")
+    print(f"[INFO] Instructions: {totals['instructions_before']} -> {totals['instructions_after']}")
+    print(f"[INFO] Pass time: {totals['total_seconds']:.3f}s")
+    print(f"[INFO] Max peak RSS: {totals['max_peak_rss_bytes'] / (1 << 20):.1f} MiB")
+
+    for name, stats in report["technique_seconds"].items():
+        print(f"[INFO]   {name:<18} sum={stats['sum']:.3f}s p50={stats['p50']:.6f}s "
+              f"p90={stats['p90']:.6f}s p99={stats['p99']:.6f}s max={stats['max']:.6f}s")
+
+    for name, sums in report["growth_by_technique"].items():
+        print(f"[INFO]   {name:<18} {sums['instructions']:+d} instructions, "
+              f"{sums['malloc_bytes'] / (1 << 20):+.1f} MiB malloc")
+    for cycle, sums in report["growth_by_cycle"].items():
+        print(f"[INFO] Cycle {cycle}: {sums['instructions']:+d} instructions, "
+              f"{sums['malloc_bytes'] / (1 << 20):+.1f} MiB malloc")
+
+    for entry in report["slowest_modules"]:
+        print(f"[INFO] Slow module: {entry['module']} ({entry['total_seconds']:.3f}s)")
+    for entry in report["growth"]["outliers"]:
+        print(f"[WARNING] Growth outlier: {entry['module']} x{entry['ratio']} "
+              f"({entry['instructions_before']} -> {entry['instructions_after']} instructions)")
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Merge per-module warp_aai telemetry into one build report")
+    parser.add_argument('paths', nargs='+',
+                        help='Telemetry files or directories to search recursively')
+    parser.add_argument('--out', default='warp_build_telemetry.json',
+                        help='Aggregated report path (default: warp_build_telemetry.json)')
+    parser.add_argument('--top', type=int, default=10,
+                        help='Number of slowest modules and growth outliers to list (default: 10)')
+    parser.add_argument('--jobs', '-j', type=int, default=os.cpu_count() or 1,
+                        help='Parallel parse workers (default: number of CPUs)')
+    parser.add_argument('--quiet', '-q', action='store_true',
+                        help='Only write the report file')
+    args = parser.parse_args()
+
+    files = collect_files(args.paths, exclude=args.out)
+    if not files:
+        print("[ERROR] No telemetry files found", file=sys.stderr)
+        return 1
+
+    records, unreadable = load_all(files, args.jobs)
+    report = aggregate(records, args.top)
+    report["unreadable_files"] = unreadable
+
+    with open(args.out, 'w') as f:
+        json.dump(report, f, indent=2)
+
+    if not args.quiet:
+        print_summary(report)
+        for path in unreadable:
+            print(f"[WARNING] Could not parse {path}")
+        print(f"[INFO] Build report saved: {args.out}")
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,370 @@
+#!/usr/bin/env python3
+"""
+warp_workloads.py - Runtime overhead of obfuscation on representative workloads
+
+Builds every program in workloads/ once without the pass and once per
+obfuscation configuration (each technique alone, then all of them), using the
+same compile pipeline as warp_aai.py. Then runs all builds with repetitions,
+interleaved in a shuffled order and pinned to one CPU. Every obfuscated run
+must reproduce the baseline output and exit code. Reports the slowdown
+(ratio of median run times) per workload and configuration, and the
+geometric mean per configuration, with bootstrap confidence intervals.
+
+With --perf, every build is also run under warp_perf, which reads hardware
+counters through perf_event_open (instructions, cycles, branch misses, L1i
+and iTLB misses, page faults), and the report adds the counter deltas and
+ratios per workload and the geometric-mean ratio per configuration. That
+tells a slowdown from extra instructions apart from one caused by lost IPC,
+e.g. bogus control flow missing the branch predictor or a larger text
+section missing the instruction cache. Counters the host does not expose
+(common in virtual machines) are reported as unavailable.
+
+EDUCATIONAL MVP ONLY - part of the warp_aai educational obfuscation toolchain.
+"""
+
+import argparse
+import json
+import math
+import os
+import random
+import shutil
+import statistics
+import subprocess
+import sys
+import tempfile
+import time
+from pathlib import Path
+
+from warp_aai import TECHNIQUES, WarpAAIToolchain
+from warp_bench import find_tool
+
+BASELINE = "baseline"
+# warp_perf counters summarized per configuration
+COUNTERS = ("instructions", "cycles", "ipc", "branch_misses", "branch_miss_rate",
+            "l1i_misses", "itlb_misses", "page_faults")
+
+
+class QuietToolchain(WarpAAIToolchain):
+    """Pipeline steps of warp_aai.py without its progress output"""
+
+    def log(self, message, level="INFO"):
+        if level in ("ERROR", "WARNING") or self.verbose:
+            super().log(message, level)
+
+
+def build_workloads(sources, configs, args, build_dir):
+    """Returns {workload: {config: binary}}"""
+    builds = {}
+    for source in sources:
+        name = Path(source).stem
+        work = os.path.join(build_dir, name)
+        os.makedirs(work, exist_ok=True)
+
+        toolchain = QuietToolchain()
+        toolchain.verbose = args.verbose
+        bitcode = toolchain.compile_to_bitcode([source], work)[0]
+
+        binaries = {BASELINE: os.path.join(work, f"{name}.{BASELINE}")}
+        toolchain.compile_to_native(bitcode, binaries[BASELINE])
+        for config in configs:
+            toolchain.techniques = [] if config == "all" else [config]
+            obfuscated = os.path.join(work, f"{name}.{config}.bc")
+            toolchain.run_obfuscation_pass(
+                bitcode, obfuscated, args.pass_lib, args.xor_key, args.bogus_count,
+                args.cycles, args.seed,
+                telemetry_file=os.path.join(work, f"{name}.{config}.json"))
+            binaries[config] = os.path.join(work, f"{name}.{config}")
+            toolchain.compile_to_native(obfuscated, binaries[config])
+        builds[name] = binaries
+        print(f"[INFO] Built {name}: {BASELINE} + {len(configs)} configurations")
+    return builds
+
+
+def pin(cpu):
+    """preexec_fn pinning the child to one CPU (Linux only)"""
+    if cpu is None or not hasattr(os, "sched_setaffinity"):
+        return None
+    return lambda: os.sched_setaffinity(0, {cpu})
+
+
+def run_once(binary, workload_args, cpu):
+    start = time.perf_counter()
+    result = subprocess.run([binary] + workload_args, capture_output=True,
+                            preexec_fn=pin(cpu))
+    return time.perf_counter() - start, result.returncode, result.stdout
+
+
+def measure(builds, args):
+    """Returns ({workload: {config: [seconds]}}, [mismatch messages])"""
+    rng = random.Random(args.seed)
+    samples = {}
+    mismatches = []
+    for name, binaries in builds.items():
+        workload_args = args.workload_args.get(name, [])
+        # Warm-up run doubles as the reference output
+        _, ref_code, ref_out = run_once(binaries[BASELINE], workload_args, args.cpu)
+        times = {config: [] for config in binaries}
+        failed = set()
+        for _ in range(args.repeat):
+            order = list(binaries)
+            rng.shuffle(order)
+            for config in order:
+                if config in failed:
+                    continue
+                seconds, code, out = run_once(binaries[config], workload_args, args.cpu)
+                if (code, out) != (ref_code, ref_out):
+                    failed.add(config)
+                    mismatches.append(f"{name} [{config}]: output or exit code "
+                                      f"differs from baseline")
+                    continue
+                times[config].append(seconds)
+        samples[name] = {config: t for config, t in times.items() if config not in failed}
+        print(f"[INFO] Measured {name}: baseline median "
+              f"{statistics.median(times[BASELINE]):.3f}s over {args.repeat} runs")
+    return samples, mismatches
+
+
+def slowdown(baseline, obfuscated):
+    return statistics.median(obfuscated) / statistics.median(baseline)
+
+
+def geomean(values):
+    return math.exp(statistics.fmean(math.log(v) for v in values))
+
+
+def bootstrap_interval(pairs, confidence, iterations, rng):
+    """CI of the geometric-mean slowdown over (baseline, obfuscated) sample pairs"""
+    estimates = []
+    for _ in range(iterations):
+        ratios = [slowdown(rng.choices(base, k=len(base)), rng.choices(obf, k=len(obf)))
+                  for base, obf in pairs]
+        estimates.append(geomean(ratios))
+    estimates.sort()
+    tail = (1 - confidence) / 2
+    low = estimates[int(tail * (iterations - 1))]
+    high = estimates[int(math.ceil((1 - tail) * (iterations - 1)))]
+    return low, high
+
+
+def analyze(samples, configs, args):
+    rng = random.Random(args.seed)
+    per_workload = {}
+    for name, times in samples.items():
+        per_workload[name] = {"baseline_median_seconds": statistics.median(times[BASELINE])}
+        for config in configs:
+            if config not in times:
+                continue
+            pair = [(times[BASELINE], times[config])]
+            low, high = bootstrap_interval(pair, args.confidence, args.bootstrap, rng)
+            per_workload[name][config] = {
+                "median_seconds": statistics.median(times[config]),
+                "slowdown": slowdown(*pair[0]),
+                "ci": [low, high],
+            }
+
+    per_config = {}
+    for config in configs:
+        pairs = [(times[BASELINE], times[config])
+                 for times in samples.values() if config in times]
+        if not pairs:
+            continue
+        low, high = bootstrap_interval(pairs, args.confidence, args.bootstrap, rng)
+        per_config[config] = {
+            "geomean_slowdown": geomean([slowdown(b, o) for b, o in pairs]),
+            "ci": [low, high],
+            "workloads": len(pairs),
+        }
+    return per_workload, per_config
+
+
+def measure_counters(builds, args, perf, work_dir):
+    """Returns {workload: warp_perf report}"""
+    reports = {}
+    for name, binaries in builds.items():
+        out = os.path.join(work_dir, f"{name}.perf.json")
+        cmd = [perf, f'-repeat={args.perf_repeat}', '-q', '-o', out,
+               '-args', ' '.join(args.workload_args.get(name, []))]
+        if args.cpu is not None:
+            cmd.append(f'-cpu={args.cpu}')
+        cmd += [f"{config}={binary}" for config, binary in binaries.items()]
+        result = subprocess.run(cmd, capture_output=True, text=True)
+        if result.returncode != 0:
+            raise RuntimeError(f"warp_perf failed for {name}:\n{result.stderr}")
+        with open(out) as f:
+            reports[name] = json.load(f)
+        print(f"[INFO] Counted {name}: {args.perf_repeat} runs per build")
+    return reports
+
+
+def analyze_counters(reports, configs):
+    """Per workload: value, delta and ratio of every counter against the
+    baseline; per configuration: geometric-mean ratio over workloads"""
+    per_workload = {}
+    ratios = {config: {counter: [] for counter in COUNTERS} for config in configs}
+    unavailable = {}
+    for name, report in reports.items():
+        unavailable.update(report["unavailable"])
+        base = report["configs"][BASELINE]["counters"]
+        per_workload[name] = {BASELINE: base}
+        for config in configs:
+            counters = report["configs"][config]["counters"]
+            entry = {}
+            for counter in COUNTERS:
+                value, reference = counters.get(counter), base.get(counter)
+                if value is None or reference is None:
+                    continue
+                entry[counter] = {"value": value, "delta": value - reference}
+                if reference > 0 and value > 0:
+                    entry[counter]["ratio"] = value / reference
+                    ratios[config][counter].append(value / reference)
+            per_workload[name][config] = entry
+
+    per_config = {config: {counter: {"geomean_ratio": geomean(values),
+                                     "workloads": len(values)}
+                           for counter, values in by_counter.items() if values}
+                  for config, by_counter in ratios.items()}
+    return {"workloads": per_workload, "configs": per_config, "unavailable": unavailable}
+
+
+def print_counter_table(counters, configs):
+    header = f"{'config':<16}" + "".join(f"{c:>17}" for c in COUNTERS)
+    print(header)
+    print("-" * len(header))
+    for config in configs:
+        row = counters["configs"].get(config, {})
+        print(f"{config:<16}" + "".join(
+            f"{row[c]['geomean_ratio']:>16.3f}x" if c in row else f"{'n/a':>17}"
+            for c in COUNTERS))
+    for counter, reason in counters["unavailable"].items():
+        print(f"[WARNING] {counter} unavailable: {reason}")
+
+
+def print_table(per_workload, per_config, configs):
+    width = max([len(name) for name in per_workload] + [8])
+    header = f"{'workload':<{width}}  " + "  ".join(f"{c:>24}" for c in configs)
+    print(header)
+    print("-" * len(header))
+
+    def cell(entry, key):
+        if not entry:
+            return f"{'FAILED':>24}"
+        low, high = entry["ci"]
+        return f"{entry[key]:>8.3f} [{low:.3f},{high:.3f}]"
+
+    for name, row in per_workload.items():
+        print(f"{name:<{width}}  " + "  ".join(cell(row.get(c), "slowdown") for c in configs))
+    print(f"{'geomean':<{width}}  " +
+          "  ".join(cell(per_config.get(c), "geomean_slowdown") for c in configs))
+
+
+def parse_workload_args(items):
+    """['fib=30', 'sort=100000'] -> {'fib': ['30'], 'sort': ['100000']}"""
+    result = {}
+    for item in items:
+        name, _, value = item.partition('=')
+        result[name] = value.split()
+    return result
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Measure the runtime slowdown of each obfuscation technique")
+    parser.add_argument('--pass-lib', required=True,
+                        help='Path to compiled obfuscation pass library')
+    parser.add_argument('--workloads', default=os.path.join(os.path.dirname(
+                        os.path.abspath(__file__)), 'workloads'),
+                        help='Directory of workload sources (default: workloads/)')
+    parser.add_argument('--only', type=lambda v: [w for w in v.split(',') if w], default=[],
+                        help='Comma-separated workload names to run (default: all)')
+    parser.add_argument('--configs', type=lambda v: [c for c in v.split(',') if c],
+                        default=list(TECHNIQUES) + ["all"],
+                        help='Configurations: technique names and/or "all" '
+                             '(default: each technique, then all)')
+    parser.add_argument('--args', dest='workload_args', action='append', default=[],
+                        metavar='NAME=ARGS', help='Arguments for one workload, e.g. fib=30')
+    parser.add_argument('--repeat', type=int, default=10,
+                        help='Runs per build (default: 10)')
+    parser.add_argument('--cpu', type=int,
+                        help='Pin every run to this CPU (default: no pinning)')
+    parser.add_argument('--confidence', type=float, default=0.95,
+                        help='Confidence level of the intervals (default: 0.95)')
+    parser.add_argument('--bootstrap', type=int, default=2000,
+                        help='Bootstrap resamples (default: 2000)')
+    parser.add_argument('--perf', action='store_true',
+                        help='Also compare hardware counters with warp_perf (Linux only)')
+    parser.add_argument('--perf-tool',
+                        help='warp_perf binary (default: build/bin, _build/bin, then PATH)')
+    parser.add_argument('--perf-repeat', type=int, default=5,
+                        help='Counted runs per build; medians are compared (default: 5)')
+    parser.add_argument('--xor-key', type=int, default=170)
+    parser.add_argument('--bogus-count', type=int, default=2)
+    parser.add_argument('--cycles', type=int, default=1)
+    parser.add_argument('--seed', type=int, default=0,
+                        help='Pass seed; also seeds run order and bootstrap (default: 0)')
+    parser.add_argument('--out', default='warp_workloads.json',
+                        help='Report path (default: warp_workloads.json)')
+    parser.add_argument('--keep-builds', metavar='DIR',
+                        help='Build into DIR and keep the binaries')
+    parser.add_argument('--verbose', '-v', action='store_true')
+    args = parser.parse_args()
+    args.workload_args = parse_workload_args(args.workload_args)
+    args.pass_lib = os.path.abspath(args.pass_lib)
+
+    unknown = set(args.configs) - set(TECHNIQUES) - {"all"}
+    if unknown:
+        parser.error(f"unknown configuration(s): {', '.join(sorted(unknown))}")
+
+    sources = sorted(str(p) for p in Path(args.workloads).glob('*.c')
+                     if not args.only or p.stem in args.only)
+    if not sources:
+        print("[ERROR] No workloads found", file=sys.stderr)
+        return 1
+
+    build_dir = args.keep_builds or tempfile.mkdtemp(prefix="warp_workloads_")
+    counters = None
+    try:
+        builds = build_workloads(sources, args.configs, args, build_dir)
+        samples, mismatches = measure(builds, args)
+        if args.perf:
+            perf = find_tool('warp_perf', args.perf_tool, '--perf-tool')
+            counters = analyze_counters(
+                measure_counters(builds, args, perf, build_dir), args.configs)
+    except RuntimeError as e:
+        print(f"[ERROR] {e}", file=sys.stderr)
+        return 1
+    finally:
+        if not args.keep_builds:
+            shutil.rmtree(build_dir, ignore_errors=True)
+
+    per_workload, per_config = analyze(samples, args.configs, args)
+    report = {
+        "parameters": {
+            "configs": args.configs, "repeat": args.repeat, "cpu": args.cpu,
+            "confidence": args.confidence, "bootstrap": args.bootstrap,
+            "xor_key": args.xor_key, "bogus_count": args.bogus_count,
+            "cycles": args.cycles, "seed": args.seed,
+            "perf_repeat": args.perf_repeat if args.perf else None,
+        },
+        "workloads": per_workload,
+        "configs": per_config,
+        "mismatches": mismatches,
+        # Per-run seconds, for statistical comparison (warp_regress.py)
+        "samples": samples,
+    }
+    if counters:
+        report["counters"] = counters
+    with open(args.out, 'w') as f:
+        json.dump(report, f, indent=2)
+
+    print_table(per_workload, per_config, args.configs)
+    if counters:
+        print()
+        print_counter_table(counters, args.configs)
+    for message in mismatches:
+        print(f"[ERROR] {message}", file=sys.stderr)
+    print(f"[INFO] Workload report saved: {args.out}")
+    return 1 if mismatches else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
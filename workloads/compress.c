@@ -0,0 +1,120 @@
+/*
+ * compress.c - Compression kernel workload (LZ77-style round trip)
+ *
+ * Usage: compress [ROUNDS]   compresses and restores 256 KiB ROUNDS times (default: 200)
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define INPUT_SIZE (256 * 1024)
+#define WINDOW 4096
+#define MIN_MATCH 4
+#define MAX_MATCH 255
+#define HASH_BITS 12
+
+static uint8_t input[INPUT_SIZE];
+static uint8_t packed[INPUT_SIZE * 2];
+static uint8_t restored[INPUT_SIZE];
+
+static uint32_t hash4(const uint8_t* p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return (v * 2654435761u) >> (32 - HASH_BITS);
+}
+
+/* Token stream: 0x00 len byte... (literals) | 0x01 len offset_lo offset_hi (match) */
+static size_t compress_block(const uint8_t* src, size_t n, uint8_t* dst) {
+    static int32_t head[1 << HASH_BITS];
+    memset(head, -1, sizeof(head));
+    size_t out = 0, i = 0, lit_start = 0;
+
+    while (i + MIN_MATCH <= n) {
+        uint32_t h = hash4(src + i);
+        int32_t cand = head[h];
+        head[h] = (int32_t)i;
+        size_t len = 0;
+        if (cand >= 0 && i - (size_t)cand <= WINDOW) {
+            while (len < MAX_MATCH && i + len < n && src[cand + len] == src[i + len]) len++;
+        }
+        if (len >= MIN_MATCH) {
+            while (lit_start < i) {
+                size_t chunk = i - lit_start > 255 ? 255 : i - lit_start;
+                dst[out++] = 0;
+                dst[out++] = (uint8_t)chunk;
+                memcpy(dst + out, src + lit_start, chunk);
+                out += chunk;
+                lit_start += chunk;
+            }
+            size_t offset = i - (size_t)cand;
+            dst[out++] = 1;
+            dst[out++] = (uint8_t)len;
+            dst[out++] = (uint8_t)offset;
+            dst[out++] = (uint8_t)(offset >> 8);
+            i += len;
+            lit_start = i;
+        } else {
+            i++;
+        }
+    }
+    while (lit_start < n) {
+        size_t chunk = n - lit_start > 255 ? 255 : n - lit_start;
+        dst[out++] = 0;
+        dst[out++] = (uint8_t)chunk;
+        memcpy(dst + out, src + lit_start, chunk);
+        out += chunk;
+        lit_start += chunk;
+    }
+    return out;
+}
+
+static size_t decompress_block(const uint8_t* src, size_t n, uint8_t* dst) {
+    size_t in = 0, out = 0;
+    while (in < n) {
+        uint8_t tag = src[in++];
+        size_t len = src[in++];
+        if (tag == 0) {
+            memcpy(dst + out, src + in, len);
+            in += len;
+        } else {
+            size_t offset = src[in] | ((size_t)src[in + 1] << 8);
+            in += 2;
+            for (size_t k = 0; k < len; k++, out++) dst[out] = dst[out - offset];
+            continue;
+        }
+        out += len;
+    }
+    return out;
+}
+
+int main(int argc, char* argv[]) {
+    int rounds = argc > 1 ? atoi(argv[1]) : 200;
+
+    /* Text-like input: words from a small vocabulary with some noise */
+    static const char* words[] = {"warp ", "obfuscation ", "module ", "string ",
+                                  "function ", "cycle ", "the ", "and "};
+    uint32_t state = 7;
+    size_t pos = 0;
+    while (pos < INPUT_SIZE) {
+        state = state * 1664525u + 1013904223u;
+        const char* w = words[(state >> 16) % 8];
+        for (size_t k = 0; w[k] && pos < INPUT_SIZE; k++) input[pos++] = (uint8_t)w[k];
+        if ((state & 0xff) == 0 && pos < INPUT_SIZE) input[pos++] = (uint8_t)(state >> 8);
+    }
+
+    size_t packed_size = 0;
+    for (int r = 0; r < rounds; r++) {
+        packed_size = compress_block(input, INPUT_SIZE, packed);
+        size_t restored_size = decompress_block(packed, packed_size, restored);
+        if (restored_size != INPUT_SIZE || memcmp(input, restored, INPUT_SIZE) != 0) {
+            fprintf(stderr, "compress: round trip mismatch in round %d\n", r);
+            return 1;
+        }
+    }
+
+    printf("compressed %d KiB to %zu bytes, %d round trips ok\n",
+           INPUT_SIZE / 1024, packed_size, rounds);
+    return 0;
+}
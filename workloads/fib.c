@@ -0,0 +1,25 @@
+/*
+ * fib.c - Recursive Fibonacci workload (call-heavy, like example.c)
+ *
+ * Usage: fib [N]   computes fib(N) recursively (default: 35)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+static long calls = 0;
+
+int calculate_fibonacci(int n) {
+    calls++;
+    if (n <= 1) {
+        return n;
+    }
+    return calculate_fibonacci(n - 1) + calculate_fibonacci(n - 2);
+}
+
+int main(int argc, char* argv[]) {
+    int n = argc > 1 ? atoi(argv[1]) : 35;
+    int result = calculate_fibonacci(n);
+    printf("fib(%d) = %d (%ld calls)\n", n, result, calls);
+    return 0;
+}
@@ -0,0 +1,49 @@
+/*
+ * hash.c - Hashing workload (tight integer loops over a buffer)
+ *
+ * Usage: hash [ROUNDS]   hashes a 1 MiB buffer ROUNDS times (default: 200)
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define BUFFER_SIZE (1 << 20)
+
+static uint8_t buffer[BUFFER_SIZE];
+
+static uint64_t fnv1a(const uint8_t* data, size_t len, uint64_t seed) {
+    uint64_t h = 0xcbf29ce484222325ULL ^ seed;
+    for (size_t i = 0; i < len; i++) {
+        h ^= data[i];
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+static uint64_t mix64(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+int main(int argc, char* argv[]) {
+    int rounds = argc > 1 ? atoi(argv[1]) : 200;
+
+    uint64_t state = 0x9e3779b97f4a7c15ULL;
+    for (size_t i = 0; i < BUFFER_SIZE; i++) {
+        state = mix64(state + i);
+        buffer[i] = (uint8_t)state;
+    }
+
+    uint64_t digest = 0;
+    for (int r = 0; r < rounds; r++) {
+        digest = mix64(digest ^ fnv1a(buffer, BUFFER_SIZE, (uint64_t)r));
+    }
+
+    printf("hash digest after %d rounds: %016llx\n", rounds, (unsigned long long)digest);
+    return 0;
+}
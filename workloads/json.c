@@ -0,0 +1,128 @@
+/*
+ * json.c - JSON parsing workload (string literals parsed at runtime)
+ *
+ * The document is a string constant, so under string encryption the parser
+ * only sees correct input if the startup decoder ran.
+ *
+ * Usage: json [ROUNDS]   parses the embedded document ROUNDS times (default: 200000)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char* document =
+    "{\"service\": \"warp-demo\", \"version\": 3, \"enabled\": true,"
+    " \"limits\": {\"rps\": 1500, \"burst\": 250, \"timeout_ms\": 30.5},"
+    " \"regions\": [\"eu-west\", \"us-east\", \"ap-south\"],"
+    " \"weights\": [0.25, 0.5, 0.125, 0.125],"
+    " \"owner\": null, \"tags\": {\"tier\": \"gold\", \"team\": \"edge\"}}";
+
+struct parser {
+    const char* p;
+    double number_sum;
+    long strings;
+    long values;
+};
+
+static int parse_value(struct parser* ps);
+
+static void skip_ws(struct parser* ps) {
+    while (*ps->p == ' ' || *ps->p == '\n' || *ps->p == '\t' || *ps->p == '\r') {
+        ps->p++;
+    }
+}
+
+static int parse_string(struct parser* ps) {
+    if (*ps->p != '"') return 0;
+    ps->p++;
+    while (*ps->p && *ps->p != '"') {
+        if (*ps->p == '\\' && ps->p[1]) ps->p++;
+        ps->p++;
+    }
+    if (*ps->p != '"') return 0;
+    ps->p++;
+    ps->strings++;
+    return 1;
+}
+
+static int parse_number(struct parser* ps) {
+    char* end;
+    double v = strtod(ps->p, &end);
+    if (end == ps->p) return 0;
+    ps->p = end;
+    ps->number_sum += v;
+    return 1;
+}
+
+static int parse_literal(struct parser* ps, const char* word) {
+    size_t len = strlen(word);
+    if (strncmp(ps->p, word, len) != 0) return 0;
+    ps->p += len;
+    return 1;
+}
+
+static int parse_array(struct parser* ps) {
+    ps->p++;
+    skip_ws(ps);
+    if (*ps->p == ']') { ps->p++; return 1; }
+    for (;;) {
+        if (!parse_value(ps)) return 0;
+        skip_ws(ps);
+        if (*ps->p == ',') { ps->p++; continue; }
+        if (*ps->p == ']') { ps->p++; return 1; }
+        return 0;
+    }
+}
+
+static int parse_object(struct parser* ps) {
+    ps->p++;
+    skip_ws(ps);
+    if (*ps->p == '}') { ps->p++; return 1; }
+    for (;;) {
+        skip_ws(ps);
+        if (!parse_string(ps)) return 0;
+        skip_ws(ps);
+        if (*ps->p != ':') return 0;
+        ps->p++;
+        if (!parse_value(ps)) return 0;
+        skip_ws(ps);
+        if (*ps->p == ',') { ps->p++; continue; }
+        if (*ps->p == '}') { ps->p++; return 1; }
+        return 0;
+    }
+}
+
+static int parse_value(struct parser* ps) {
+    skip_ws(ps);
+    ps->values++;
+    switch (*ps->p) {
+    case '{': return parse_object(ps);
+    case '[': return parse_array(ps);
+    case '"': return parse_string(ps);
+    case 't': return parse_literal(ps, "true");
+    case 'f': return parse_literal(ps, "false");
+    case 'n': return parse_literal(ps, "null");
+    default:  return parse_number(ps);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    long rounds = argc > 1 ? atol(argv[1]) : 200000;
+    struct parser total = {0};
+
+    for (long r = 0; r < rounds; r++) {
+        struct parser ps = {document, 0.0, 0, 0};
+        if (!parse_value(&ps)) {
+            fprintf(stderr, "json: parse error at offset %ld\n", (long)(ps.p - document));
+            return 1;
+        }
+        total.number_sum += ps.number_sum;
+        total.strings += ps.strings;
+        total.values += ps.values;
+    }
+
+    printf("parsed %ld documents: %ld values, %ld strings, number sum %.3f\n",
+           rounds, total.values, total.strings, total.number_sum);
+    return 0;
+}
@@ -0,0 +1,69 @@
+/*
+ * logger.c - String-heavy logging workload
+ *
+ * Formats log lines from many distinct string constants (levels, components,
+ * message templates) into a ring buffer, the way a busy service logs.
+ *
+ * Usage: logger [LINES]   formats LINES log lines (default: 1000000)
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char* levels[] = {"TRACE", "DEBUG", "INFO", "WARN", "ERROR"};
+
+static const char* components[] = {
+    "http.server", "http.client", "db.pool", "db.query", "cache.lru",
+    "auth.session", "auth.token", "queue.consumer", "queue.producer", "scheduler",
+};
+
+static const char* templates[] = {
+    "request %s completed in %d ms",
+    "connection %s opened from pool slot %d",
+    "cache miss for key %s (size %d)",
+    "token %s refreshed, expires in %d s",
+    "job %s scheduled with priority %d",
+    "retrying operation %s, attempt %d",
+    "slow query detected on %s: %d ms",
+    "message %s acknowledged after %d deliveries",
+};
+
+static const char* ids[] = {"a1f3", "b72c", "c09e", "d4d4", "e5a0", "f611"};
+
+#define RING_LINES 64
+#define LINE_SIZE 256
+
+static char ring[RING_LINES][LINE_SIZE];
+
+static uint64_t checksum_line(const char* line) {
+    uint64_t h = 1469598103934665603ULL;
+    for (const char* c = line; *c; c++) {
+        h = (h ^ (uint8_t)*c) * 1099511628211ULL;
+    }
+    return h;
+}
+
+int main(int argc, char* argv[]) {
+    long lines = argc > 1 ? atol(argv[1]) : 1000000;
+    uint64_t checksum = 0;
+    size_t bytes = 0;
+
+    for (long i = 0; i < lines; i++) {
+        char message[160];
+        const char* tmpl = templates[i % 8];
+        snprintf(message, sizeof(message), tmpl, ids[i % 6], (int)(i % 997));
+
+        char* line = ring[i % RING_LINES];
+        int n = snprintf(line, LINE_SIZE, "[%08ld] %-5s %-14s %s",
+                         i, levels[i % 5], components[i % 10], message);
+        bytes += (size_t)n;
+        checksum ^= checksum_line(line) + (uint64_t)i;
+    }
+
+    printf("logged %ld lines (%zu bytes), checksum %016llx\n",
+           lines, bytes, (unsigned long long)checksum);
+    printf("last line: %s\n", ring[(lines - 1) % RING_LINES]);
+    return 0;
+}
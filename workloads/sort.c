@@ -0,0 +1,68 @@
+/*
+ * sort.c - Sorting workload (qsort callbacks plus a hand-written merge sort)
+ *
+ * Usage: sort [N]   sorts N pseudo-random integers both ways (default: 1000000)
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int compare_ints(const void* a, const void* b) {
+    int x = *(const int*)a;
+    int y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+static void merge_sort(int* data, int* scratch, size_t n) {
+    if (n < 2) {
+        return;
+    }
+    size_t mid = n / 2;
+    merge_sort(data, scratch, mid);
+    merge_sort(data + mid, scratch, n - mid);
+
+    size_t i = 0, j = mid, k = 0;
+    while (i < mid && j < n) {
+        scratch[k++] = data[i] <= data[j] ? data[i++] : data[j++];
+    }
+    while (i < mid) scratch[k++] = data[i++];
+    while (j < n) scratch[k++] = data[j++];
+    memcpy(data, scratch, n * sizeof(int));
+}
+
+int main(int argc, char* argv[]) {
+    size_t n = argc > 1 ? (size_t)atol(argv[1]) : 1000000;
+    int* a = malloc(n * sizeof(int));
+    int* b = malloc(n * sizeof(int));
+    int* scratch = malloc(n * sizeof(int));
+    if (!a || !b || !scratch) {
+        fprintf(stderr, "sort: out of memory\n");
+        return 1;
+    }
+
+    uint32_t state = 12345;
+    for (size_t i = 0; i < n; i++) {
+        state = state * 1103515245u + 12345u;
+        a[i] = b[i] = (int)(state >> 1);
+    }
+
+    qsort(a, n, sizeof(int), compare_ints);
+    merge_sort(b, scratch, n);
+
+    uint64_t checksum = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (a[i] != b[i]) {
+            fprintf(stderr, "sort: mismatch at %zu\n", i);
+            return 1;
+        }
+        checksum = checksum * 31 + (uint32_t)a[i];
+    }
+
+    printf("sorted %zu integers, checksum %016llx\n", n, (unsigned long long)checksum);
+    free(a);
+    free(b);
+    free(scratch);
+    return 0;
+}